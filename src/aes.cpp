@@ -0,0 +1,245 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "aes.hpp"
+#include "block.hpp"
+#include "key.hpp"
+
+namespace {
+    constexpr const std::array<std::uint8_t, 256> SBOX = {
+        0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+        0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+        0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+        0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+        0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+        0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+        0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+        0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+        0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+        0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+        0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+        0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+        0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+        0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+        0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+        0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+    };
+
+    constexpr const std::array<std::uint8_t, fc::Aes::ROUNDS> RCON = {
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36
+    };
+
+    inline std::uint8_t MultiplyBy2(const std::uint8_t value) noexcept {
+        // Multiplication by 'x' in GF(2^8).
+        return static_cast<std::uint8_t>((value << 1) ^ ((value & 0x80) != 0 ? 0x1B : 0x00));
+    }
+
+    inline void MakeCounter(std::uint8_t* counter, const std::uint64_t index) noexcept {
+        // Counter block: 8 zero bytes (the key is unique per file) and big-endian block index.
+        std::fill(counter, counter + 8, 0);
+        for (std::size_t position = 0; position < 8; position++) {
+            counter[15 - position] = static_cast<std::uint8_t>(index >> (8 * position));
+        }
+    }
+
+    void EncryptPortable(std::uint8_t* state, const std::uint8_t* roundKeys) noexcept {
+        // Initial round key.
+        for (std::size_t index = 0; index < fc::Block::SIZE; index++) {
+            state[index] ^= roundKeys[index];
+        }
+
+        // Main rounds (the last one has no MixColumns).
+        for (std::size_t round = 1; round <= fc::Aes::ROUNDS; round++) {
+            // SubBytes and ShiftRows (state is stored by columns).
+            std::array<std::uint8_t, fc::Block::SIZE> shifted;
+            for (std::size_t column = 0; column < 4; column++) {
+                for (std::size_t row = 0; row < 4; row++) {
+                    shifted[column * 4 + row] = SBOX[state[((column + row) % 4) * 4 + row]];
+                }
+            }
+
+            // MixColumns.
+            if (round != fc::Aes::ROUNDS) {
+                for (std::size_t column = 0; column < 4; column++) {
+                    const auto a = &shifted[column * 4];
+                    const std::uint8_t all = a[0] ^ a[1] ^ a[2] ^ a[3];
+                    const std::uint8_t first = a[0];
+                    a[0] ^= all ^ MultiplyBy2(a[0] ^ a[1]);
+                    a[1] ^= all ^ MultiplyBy2(a[1] ^ a[2]);
+                    a[2] ^= all ^ MultiplyBy2(a[2] ^ a[3]);
+                    a[3] ^= all ^ MultiplyBy2(a[3] ^ first);
+                }
+            }
+
+            // AddRoundKey.
+            for (std::size_t index = 0; index < fc::Block::SIZE; index++) {
+                state[index] = shifted[index] ^ roundKeys[round * fc::Block::SIZE + index];
+            }
+        }
+    }
+
+    void CryptPortable(std::span<std::uint8_t> bytes, const std::uint64_t offset, const std::uint8_t* roundKeys) {
+        // Process the stream block by block.
+        std::size_t done = 0;
+        while (done < bytes.size()) {
+            // Find the block of the key stream and the position in it.
+            const auto position = offset + done;
+            const auto skip = static_cast<std::size_t>(position % fc::Block::SIZE);
+            const auto length = std::min(fc::Block::SIZE - skip, bytes.size() - done);
+
+            // Produce the key stream block.
+            std::array<std::uint8_t, fc::Block::SIZE> stream;
+            MakeCounter(stream.data(), position / fc::Block::SIZE);
+            EncryptPortable(stream.data(), roundKeys);
+
+            // Combine it with the data.
+            for (std::size_t index = 0; index < length; index++) {
+                bytes[done + index] ^= stream[skip + index];
+            }
+            done += length;
+        }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    __attribute__((target("aes,sse4.1")))
+    inline __m128i EncryptAESNI(__m128i state, const __m128i* keys) noexcept {
+        // Encrypt one block with AES-NI.
+        state = _mm_xor_si128(state, keys[0]);
+        for (std::size_t round = 1; round < fc::Aes::ROUNDS; round++) {
+            state = _mm_aesenc_si128(state, keys[round]);
+        }
+        return _mm_aesenclast_si128(state, keys[fc::Aes::ROUNDS]);
+    }
+
+    __attribute__((target("aes,sse4.1")))
+    void CryptAESNI(std::span<std::uint8_t> bytes, const std::uint64_t offset, const std::uint8_t* roundKeys) {
+        // Load round keys.
+        __m128i keys[fc::Aes::ROUNDS + 1];
+        for (std::size_t round = 0; round <= fc::Aes::ROUNDS; round++) {
+            keys[round] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(roundKeys + round * fc::Block::SIZE));
+        }
+
+        // Process an unaligned beginning with the portable code.
+        const auto head = std::min(
+            bytes.size(), static_cast<std::size_t>((fc::Block::SIZE - offset % fc::Block::SIZE) % fc::Block::SIZE)
+        );
+        CryptPortable(bytes.first(head), offset, roundKeys);
+
+        // Process 4 blocks at a time (AES instructions are pipelined); counters are big-endian.
+        const auto swap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        auto index = (offset + head) / fc::Block::SIZE;
+        auto data = bytes.data() + head;
+        auto count = (bytes.size() - head) / fc::Block::SIZE;
+        for (; count >= 4; count -= 4, index += 4, data += 4 * fc::Block::SIZE) {
+            __m128i stream[4];
+            for (std::size_t lane = 0; lane < 4; lane++) {
+                const auto counter = _mm_set_epi64x(0, static_cast<long long>(index + lane));
+                stream[lane] = _mm_xor_si128(_mm_shuffle_epi8(counter, swap), keys[0]);
+            }
+            for (std::size_t round = 1; round < fc::Aes::ROUNDS; round++) {
+                for (std::size_t lane = 0; lane < 4; lane++) {
+                    stream[lane] = _mm_aesenc_si128(stream[lane], keys[round]);
+                }
+            }
+            for (std::size_t lane = 0; lane < 4; lane++) {
+                const auto address = reinterpret_cast<__m128i*>(data + lane * fc::Block::SIZE);
+                stream[lane] = _mm_aesenclast_si128(stream[lane], keys[fc::Aes::ROUNDS]);
+                _mm_storeu_si128(address, _mm_xor_si128(_mm_loadu_si128(address), stream[lane]));
+            }
+        }
+
+        // Process the rest of full blocks.
+        for (; count > 0; count--, index++, data += fc::Block::SIZE) {
+            const auto counter = _mm_set_epi64x(0, static_cast<long long>(index));
+            const auto stream = EncryptAESNI(_mm_shuffle_epi8(counter, swap), keys);
+            const auto address = reinterpret_cast<__m128i*>(data);
+            _mm_storeu_si128(address, _mm_xor_si128(_mm_loadu_si128(address), stream));
+        }
+
+        // Process the partial (last) block with the portable code.
+        const auto done = static_cast<std::size_t>(data - bytes.data());
+        CryptPortable(bytes.subspan(done), offset + done, roundKeys);
+    }
+#endif
+}
+
+fc::Aes::Aes() {
+    // Without a key all round keys are empty.
+    roundKeys.fill(0);
+}
+
+fc::Aes::Aes(const fc::Key& key) {
+    // The first round key is the key itself.
+    std::copy(key.GetBytes().begin(), key.GetBytes().end(), roundKeys.begin());
+
+    // Expand the key (4-byte words).
+    for (std::size_t word = 4; word < 4 * (ROUNDS + 1); word++) {
+        // Take the previous word.
+        std::array<std::uint8_t, 4> temp;
+        std::copy_n(roundKeys.begin() + (word - 1) * 4, 4, temp.begin());
+
+        // Rotate, substitute and add the round constant at the beginning of each round key.
+        if (word % 4 == 0) {
+            const auto first = temp[0];
+            temp[0] = SBOX[temp[1]] ^ RCON[word / 4 - 1];
+            temp[1] = SBOX[temp[2]];
+            temp[2] = SBOX[temp[3]];
+            temp[3] = SBOX[first];
+        }
+
+        // Combine it with the word of the previous round key.
+        for (std::size_t index = 0; index < 4; index++) {
+            roundKeys[word * 4 + index] = roundKeys[(word - 4) * 4 + index] ^ temp[index];
+        }
+    }
+}
+
+fc::Aes::~Aes() noexcept {
+    // Do not leave round keys in memory.
+    explicit_bzero(roundKeys.data(), roundKeys.size());
+}
+
+void fc::Aes::Crypt(std::span<std::uint8_t> bytes, const std::uint64_t offset) const noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    // Use AES instructions if the CPU has them.
+    if (__builtin_cpu_supports("aes") && __builtin_cpu_supports("sse4.1")) {
+        CryptAESNI(bytes, offset, roundKeys.data());
+        return;
+    }
+#endif
+
+    // Use the portable code.
+    CryptPortable(bytes, offset, roundKeys.data());
+}
+
+fc::Block fc::Aes::EncryptBlock(const fc::Block& block) const noexcept {
+    // Encrypt a copy of the block.
+    Block result(block);
+    EncryptPortable(result.GetData(), roundKeys.data());
+    return result;
+}
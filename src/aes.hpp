@@ -0,0 +1,54 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_AES_HPP
+#define FISHCODE_AES_HPP
+
+#include <array>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include "key.hpp"
+
+namespace fc {
+    // AES-128 in counter mode (AES-NI when available, portable code otherwise).
+    class Aes {
+    public:
+        static constexpr const std::size_t ROUNDS = 10;
+
+        Aes();
+        Aes(const Key& key);
+        Aes(const Aes& otherAes) = default;
+        Aes(Aes&& otherAes) noexcept = default;
+
+        ~Aes() noexcept;
+
+        Aes& operator=(const Aes& otherAes) = default;
+        Aes& operator=(Aes&& otherAes) noexcept = default;
+
+        // XOR bytes with the key stream starting at byte 'offset' of the stream (encryption and decryption).
+        void Crypt(std::span<std::uint8_t> bytes, const std::uint64_t offset) const noexcept;
+
+        Block EncryptBlock(const Block& block) const noexcept;
+    private:
+        std::array<std::uint8_t, Block::SIZE * (ROUNDS + 1)> roundKeys;
+    };
+}
+
+#endif // FISHCODE_AES_HPP
@@ -0,0 +1,76 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include "anonymous.hpp"
+#include "descriptor.hpp"
+
+fc::AnonymousFile::AnonymousFile(const std::filesystem::path& fsPath) {
+    // Create the file in the directory of the output file (so it can be linked there).
+    auto directory = fsPath.parent_path();
+    if (directory.empty()) {
+        directory = ".";
+    }
+    fd = open(directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), directory.string());
+    }
+
+    // The file is reopened by its descriptor (e.g., by the streams).
+    path = std::filesystem::path("/proc/self/fd") / std::to_string(fd);
+}
+
+fc::AnonymousFile::~AnonymousFile() noexcept {
+    // Close the file.
+    close(fd);
+}
+
+void fc::AnonymousFile::Link(const std::filesystem::path& fsPath) {
+    // Flush the data first (a crash never leaves a partial file under the name).
+    if (fdatasync(fd) != 0) {
+        throw std::system_error(errno, std::generic_category(), "fdatasync");
+    }
+
+    // Link the file to a new temporary name next to the output file (linkat never replaces a file).
+    const auto temporaryPath = CreateTemporary(fsPath, [&](const std::filesystem::path& candidatePath) {
+        if (linkat(AT_FDCWD, path.c_str(), AT_FDCWD, candidatePath.c_str(), AT_SYMLINK_FOLLOW) == 0) {
+            return true;
+        }
+        if (errno == EEXIST) {
+            return false;
+        }
+        throw std::system_error(errno, std::generic_category(), "linkat");
+    });
+
+    // Replace the output file at once (the temporary name is removed if it fails).
+    std::error_code code;
+    std::filesystem::rename(temporaryPath, fsPath, code);
+    if (code) {
+        std::filesystem::remove(temporaryPath);
+        throw std::system_error(code, "rename");
+    }
+
+    // Make the name durable (a crash leaves either the old or the new file).
+    SyncDirectory(fsPath);
+}
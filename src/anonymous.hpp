@@ -0,0 +1,54 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_ANONYMOUS_HPP
+#define FISHCODE_ANONYMOUS_HPP
+
+#include <filesystem>
+
+namespace fc {
+    // Unnamed file (O_TMPFILE) in the directory of the output file. It is opened by its descriptor path, written as
+    // any other file and gets its name only by Link, so a cancelled or failed task leaves nothing to remove.
+    class AnonymousFile {
+    public:
+        // Throws std::system_error (e.g., EOPNOTSUPP if the file system does not support unnamed files).
+        explicit AnonymousFile(const std::filesystem::path& fsPath);
+        AnonymousFile(const AnonymousFile& otherFile) = delete;
+        AnonymousFile(AnonymousFile&& otherFile) noexcept = delete;
+
+        // Closes the file (the file system frees it if it has no name).
+        ~AnonymousFile() noexcept;
+
+        AnonymousFile& operator=(const AnonymousFile& otherFile) = delete;
+        AnonymousFile& operator=(AnonymousFile&& otherFile) noexcept = delete;
+
+        // Path opening the same file ("/proc/self/fd/N").
+        inline const std::filesystem::path& GetPath() const noexcept {
+            return path;
+        }
+
+        // Flushes the data to the disk and gives the file its name (an existing file is replaced at once).
+        void Link(const std::filesystem::path& fsPath);
+    private:
+        int fd;
+        std::filesystem::path path;
+    };
+}
+
+#endif // FISHCODE_ANONYMOUS_HPP
@@ -0,0 +1,51 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_BACKEND_HPP
+#define FISHCODE_BACKEND_HPP
+
+#include <span>
+#include <cstddef>
+#include <cstdint>
+
+namespace fc {
+    // Sequential I/O of an open file, File selects one implementation (see FileBackend) when the file is opened.
+    class Backend {
+    public:
+        virtual ~Backend() noexcept = default;
+
+        // Size of a block device (0 for other files).
+        virtual std::uint64_t GetDeviceSize() const noexcept = 0;
+
+        // Size of the file (new output file is empty).
+        virtual std::uint64_t GetSize() const noexcept = 0;
+
+        // Writes the buffered bytes of the output file.
+        virtual void Flush() = 0;
+
+        // Reads up to 'bytes.size()' bytes (less only at the end of the file), returns the number of bytes read.
+        virtual std::size_t Read(std::span<std::uint8_t> bytes) = 0;
+
+        // Moves the position past 'count' bytes (skipped output bytes are a hole).
+        virtual void Skip(const std::uint64_t count) = 0;
+        virtual void Write(std::span<const std::uint8_t> bytes) = 0;
+    };
+}
+
+#endif // FISHCODE_BACKEND_HPP
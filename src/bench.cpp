@@ -0,0 +1,300 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "block.hpp"
+#include "cipher.hpp"
+#include "compiled.hpp"
+#include "kernel.hpp"
+#include "key.hpp"
+
+namespace {
+    constexpr const std::size_t MIN_SIZE = 16;
+    constexpr const std::size_t MAX_SIZE = static_cast<std::size_t>(1) << 30;
+
+    // Benchmark configuration (from the command line).
+    struct Options {
+        std::size_t maxSize = MAX_SIZE;
+        double minTime = 0.2;
+        std::string outputPath;
+    };
+
+    // Result of one benchmark run.
+    struct Result {
+        std::string name;
+        std::string kernel;
+        std::size_t size;
+        std::size_t iterations;
+        double seconds;
+        double cycles;
+    };
+
+    inline std::uint64_t ReadCycles() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        // Time stamp counter (reference cycles).
+        return __rdtsc();
+#else
+        // There is no portable cycle counter.
+        return 0;
+#endif
+    }
+
+    Result Measure(const std::string& name, const std::string& kernel, const std::size_t size, const double minTime,
+                   const std::function<void()>& body) {
+        // Warm up (caches, page faults, frequency).
+        body();
+
+        // Repeat the body until the minimal time has passed.
+        std::size_t iterations = 0;
+        const auto startCycles = ReadCycles();
+        const auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed(0);
+        do {
+            body();
+            iterations++;
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed.count() < minTime);
+        const auto cycles = static_cast<double>(ReadCycles() - startCycles);
+
+        // Return the result.
+        return Result{name, kernel, size, iterations, elapsed.count(), cycles};
+    }
+
+    void PrintJSON(std::ostream& stream, const std::vector<Result>& results) {
+        // Print results as an array of JSON objects (one per line).
+        stream << "{\n  \"results\": [\n";
+        for (std::size_t index = 0; index < results.size(); index++) {
+            const auto& result = results[index];
+            const auto bytes = static_cast<double>(result.size) * static_cast<double>(result.iterations);
+            stream << "    {\"name\": \"" << result.name << "\", \"kernel\": \"" << result.kernel << "\", "
+                   << "\"size\": " << result.size << ", \"iterations\": " << result.iterations << ", "
+                   << "\"seconds\": " << result.seconds << ", \"gbps\": " << bytes / result.seconds / 1e9 << ", ";
+            if (result.cycles > 0) {
+                stream << "\"cycles_per_byte\": " << result.cycles / bytes << "}";
+            } else {
+                stream << "\"cycles_per_byte\": null}";
+            }
+            stream << (index + 1 < results.size() ? ",\n" : "\n");
+        }
+        stream << "  ]\n}\n";
+    }
+
+    void PrintTable(std::ostream& stream, const Result& result) {
+        // Print one human-readable line.
+        const auto bytes = static_cast<double>(result.size) * static_cast<double>(result.iterations);
+        stream << std::left << std::setw(24) << result.name << std::setw(8) << result.kernel << std::right
+               << std::setw(12) << result.size << std::fixed << std::setprecision(3) << std::setw(12)
+               << bytes / result.seconds / 1e9 << " GB/s" << std::setw(10) << result.cycles / bytes << " c/B"
+               << std::defaultfloat << std::endl;
+    }
+
+    Options ParseOptions(int argc, char* argv[]) {
+        // Default configuration.
+        Options options;
+
+        // Parse arguments.
+        for (int index = 1; index < argc; index++) {
+            const std::string_view argument(argv[index]);
+            if (argument == "--max-size" && index + 1 < argc) {
+                options.maxSize = std::stoull(argv[++index]);
+            } else if (argument == "--min-time" && index + 1 < argc) {
+                options.minTime = std::stod(argv[++index]);
+            } else if (argument == "--output" && index + 1 < argc) {
+                options.outputPath = argv[++index];
+            } else {
+                throw std::invalid_argument(
+                    "usage: fishcode_bench [--max-size BYTES] [--min-time SECONDS] [--output FILE.json]"
+                );
+            }
+        }
+
+        // Return configuration.
+        return options;
+    }
+
+    bool Verify(const fc::kernel::Kernel& kernel, const fc::Key& key, const fc::CompiledKey& compiledKey) {
+        // Prepare a few blocks of test data.
+        constexpr const std::size_t count = 64;
+        std::vector<std::uint8_t> reference(count * fc::Block::SIZE), bytes;
+        for (std::size_t index = 0; index < reference.size(); index++) {
+            reference[index] = static_cast<std::uint8_t>(index * 131 + 7);
+        }
+        bytes = reference;
+
+        // Encrypt them with the reference rounds.
+        for (std::size_t current = 0; current < count; current++) {
+            auto blocks = std::span<std::uint8_t>(reference).subspan(current * fc::Block::SIZE, fc::Block::SIZE);
+            fc::Block block;
+            std::copy(blocks.begin(), blocks.end(), block.GetData());
+            block.Encrypt(key);
+            std::copy(block.GetBytes().begin(), block.GetBytes().end(), blocks.begin());
+        }
+
+        // Compare with the kernel output.
+        kernel.Encrypt(bytes.data(), count, compiledKey);
+        if (bytes != reference) {
+            return false;
+        }
+
+        // Check the round trip.
+        kernel.Decrypt(bytes.data(), count, compiledKey);
+        for (std::size_t index = 0; index < bytes.size(); index++) {
+            if (bytes[index] != static_cast<std::uint8_t>(index * 131 + 7)) {
+                return false;
+            }
+        }
+
+        // Kernel is bit-exact.
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) try {
+    // Parse command line.
+    const auto options = ParseOptions(argc, argv);
+
+    // Prepare the key.
+    const auto key = fc::Key::Generate();
+    const fc::CompiledKey compiledKey(key);
+
+    // Remember the kernel chosen for this CPU.
+    const std::string defaultKernel = fc::kernel::GetActive().name;
+
+    // Storage for the results.
+    std::vector<Result> results;
+    const auto store = [&results](Result&& result) {
+        PrintTable(std::cerr, result);
+        results.push_back(std::move(result));
+    };
+
+    // Benchmark round key derivation (one key per call).
+    {
+        int round = 0;
+        store(Measure("Key::GetRoundKey", "-", fc::Key::SIZE, options.minTime, [&key, &round]() {
+            const auto roundKey = key.GetRoundKey(round);
+            round = (round + roundKey.GetBytes()[0]) % 15;
+        }));
+    }
+
+    // Benchmark key generation (one key per call).
+    store(Measure("Key::Generate", "pool", fc::Key::SIZE, options.minTime, []() {
+        const auto generated = fc::Key::Generate();
+        static_cast<void>(generated);
+    }));
+
+    // Benchmark all sizes from 16 bytes to the maximum (x4 each step).
+    for (std::size_t size = MIN_SIZE; size <= options.maxSize; size *= 4) {
+        // Allocate whole blocks, the span API sees their bytes (the last block may be partial).
+        std::vector<fc::Block> blocks((size + fc::Block::SIZE - 1) / fc::Block::SIZE);
+        const auto bytes = std::span<std::uint8_t>(blocks.front().GetData(), size);
+        std::fill(bytes.begin(), bytes.end(), 0xA5);
+
+        // Reference rounds (Block::Encrypt/Decrypt with a key).
+        store(Measure("Block::Encrypt", "rounds", size, options.minTime, [&blocks, &key]() {
+            for (auto& block : blocks) {
+                block.Encrypt(key);
+            }
+        }));
+        store(Measure("Block::Decrypt", "rounds", size, options.minTime, [&blocks, &key]() {
+            for (auto& block : blocks) {
+                block.Decrypt(key);
+            }
+        }));
+
+        // Compiled key, block by block.
+        store(Measure("Block::Encrypt", "compiled", size, options.minTime, [&blocks, &compiledKey]() {
+            for (auto& block : blocks) {
+                block.Encrypt(compiledKey);
+            }
+        }));
+        store(Measure("Block::Decrypt", "compiled", size, options.minTime, [&blocks, &compiledKey]() {
+            for (auto& block : blocks) {
+                block.Decrypt(compiledKey);
+            }
+        }));
+
+        // Bulk kernels (every kernel supported by this CPU).
+        for (const auto& kernel : fc::kernel::GetKernels()) {
+            // Skip kernels this CPU cannot run.
+            if (!kernel.IsSupported()) {
+                continue;
+            }
+
+            // Check the kernel against the reference rounds (only once).
+            if (size == MIN_SIZE && !Verify(kernel, key, compiledKey)) {
+                std::cerr << "Kernel \"" << kernel.name << "\" is not bit-exact!" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            // Use this kernel for the span API.
+            fc::kernel::SetActive(kernel.name);
+
+            // Measure the span API (full blocks and the partial one).
+            store(Measure("CompiledKey::Encrypt", kernel.name, size, options.minTime, [&bytes, &compiledKey]() {
+                compiledKey.Encrypt(bytes);
+            }));
+            store(Measure("CompiledKey::Decrypt", kernel.name, size, options.minTime, [&bytes, &compiledKey]() {
+                compiledKey.Decrypt(bytes);
+            }));
+        }
+
+        // Measure AES-128-CTR suite (the same operation in both directions).
+        const fc::Cipher aes(fc::CipherSuite::CS_AES128_CTR, key);
+        store(Measure("Cipher::Encrypt", "aes-ctr", size, options.minTime, [&bytes, &aes]() {
+            aes.Encrypt(bytes, 0);
+        }));
+
+        // Restore the default kernel.
+        fc::kernel::SetActive(defaultKernel);
+    }
+
+    // Write the results.
+    if (options.outputPath.empty()) {
+        PrintJSON(std::cout, results);
+    } else {
+        std::ofstream output(options.outputPath);
+        PrintJSON(output, results);
+    }
+
+    // Done.
+    return EXIT_SUCCESS;
+} catch (const std::exception& ex) {
+    // Print error message to the terminal.
+    std::cerr << ex.what() << std::endl;
+
+    // Abnormal termination.
+    return EXIT_FAILURE;
+}
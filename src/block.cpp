@@ -18,29 +18,39 @@
 */
 
 #include <array>
-#include <utility>
 #include <cstddef>
 #include <cstdint>
 #include "block.hpp"
+#include "compiled.hpp"
+#include "kernel.hpp"
 #include "key.hpp"
 
-fc::Block::Block() {
+fc::Block::Block() noexcept {
     // Initialize block bytes with zeros.
     bytes.fill(0);
+}
+
+fc::Block::Block(const std::array<std::uint8_t, fc::Block::SIZE>& newBytes) noexcept
+: bytes(newBytes) {
 
-    // Now it is empty block.
-    realSize = 0;
 }
 
-fc::Block::Block(std::array<std::uint8_t, fc::Block::SIZE>&& newBytes, const std::size_t newRealSize) noexcept {
-    // Initialize block bytes.
-    bytes = std::move(newBytes);
+void fc::Block::DecryptBlocks(std::uint8_t* bytes, const std::size_t count, const fc::CompiledKey& key) noexcept {
+    // Use the kernel chosen for this CPU.
+    kernel::GetActive().Decrypt(bytes, count, key);
+}
 
-    // Store real size of the block.
-    realSize = newRealSize;
+void fc::Block::EncryptBlocks(std::uint8_t* bytes, const std::size_t count, const fc::CompiledKey& key) noexcept {
+    // Use the kernel chosen for this CPU.
+    kernel::GetActive().Encrypt(bytes, count, key);
 }
 
-void fc::Block::Encrypt(const fc::Key& key) {
+void fc::Block::Encrypt(const fc::CompiledKey& key, const std::size_t realSize) noexcept {
+    // Encrypt block in one pass (all rounds are precomputed).
+    key.Encrypt(bytes.data(), realSize);
+}
+
+void fc::Block::Encrypt(const fc::Key& key, const std::size_t realSize) {
     // Encrypt block within 15 rounds.
     for (int round = 0; round < 15; round++) {
         // Step 1: swap bytes.
@@ -65,7 +75,12 @@ void fc::Block::Encrypt(const fc::Key& key) {
     }
 }
 
-void fc::Block::Decrypt(const fc::Key& key) {
+void fc::Block::Decrypt(const fc::CompiledKey& key, const std::size_t realSize) noexcept {
+    // Decrypt block in one pass (all rounds are precomputed).
+    key.Decrypt(bytes.data(), realSize);
+}
+
+void fc::Block::Decrypt(const fc::Key& key, const std::size_t realSize) {
     // Decrypt block within 15 rounds.
     for (int round = 14; round >= 0; round--) {
         // Step 1: get round key.
@@ -21,49 +21,57 @@
 #define FISHCODE_BLOCK_HPP
 
 #include <array>
-#include <utility>
+#include <type_traits>
 #include <cstddef>
 #include <cstdint>
 
 namespace fc {
+    class CompiledKey;
     class Key;
 
+    // Plain 16-byte value: the number of meaningful bytes (real size) is passed separately.
     class Block {
     public:
         static constexpr const std::size_t SIZE = 16;
 
-        Block();
-        Block(std::array<std::uint8_t, SIZE>&& newBytes, const std::size_t newRealSize) noexcept;
+        Block() noexcept;
+        Block(const std::array<std::uint8_t, SIZE>& newBytes) noexcept;
         Block(const Block& otherBlock) = default;
         Block(Block&& otherBlock) noexcept = default;
 
-        virtual ~Block() noexcept = default;
+        ~Block() noexcept = default;
 
         Block& operator=(const Block& otherBlock) = default;
         Block& operator=(Block&& otherBlock) noexcept = default;
 
-        inline std::array<std::uint8_t, SIZE> GetBytes() const {
+        inline const std::array<std::uint8_t, SIZE>& GetBytes() const noexcept {
             return bytes;
         }
 
-        inline std::size_t GetRealSize() const noexcept {
-            return realSize;
+        inline std::uint8_t* GetData() noexcept {
+            return bytes.data();
         }
 
-        void Decrypt(const Key& key);
-        void Encrypt(const Key& key);
-    protected:
-        inline void SetBytes(std::array<uint8_t, SIZE>&& newBytes) noexcept {
-            bytes = std::move(newBytes);
+        inline const std::uint8_t* GetData() const noexcept {
+            return bytes.data();
         }
 
-        inline void SetRealSize(const std::size_t newRealSize) noexcept {
-            realSize = newRealSize;
+        static void DecryptBlocks(std::uint8_t* bytes, const std::size_t count, const CompiledKey& key) noexcept;
+        static void EncryptBlocks(std::uint8_t* bytes, const std::size_t count, const CompiledKey& key) noexcept;
+
+        void Decrypt(const CompiledKey& key, const std::size_t realSize = SIZE) noexcept;
+        void Decrypt(const Key& key, const std::size_t realSize = SIZE);
+        void Encrypt(const CompiledKey& key, const std::size_t realSize = SIZE) noexcept;
+        void Encrypt(const Key& key, const std::size_t realSize = SIZE);
+    protected:
+        inline void SetBytes(const std::array<uint8_t, SIZE>& newBytes) noexcept {
+            bytes = newBytes;
         }
     private:
         std::array<std::uint8_t, SIZE> bytes;
-        std::size_t realSize;
     };
+
+    static_assert(std::is_trivially_copyable_v<Block> && sizeof(Block) == Block::SIZE);
 }
 
 #endif // FISHCODE_BLOCK_HPP
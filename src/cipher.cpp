@@ -0,0 +1,112 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include "aes.hpp"
+#include "block.hpp"
+#include "cipher.hpp"
+#include "compiled.hpp"
+#include "key.hpp"
+
+fc::Cipher::Cipher() {
+    // Use the original algorithm by default.
+    suite = CipherSuite::CS_FISHCODE;
+}
+
+fc::Cipher::Cipher(const fc::CipherSuite newSuite, const fc::Key& key)
+: suite(newSuite) {
+    // Prepare only the key schedule of the selected suite.
+    if (suite == CipherSuite::CS_AES128_CTR) {
+        aes = Aes(key);
+    } else {
+        compiledKey = CompiledKey(key);
+    }
+}
+
+bool fc::Cipher::IsSuite(const std::uint8_t value) noexcept {
+    // Check if the value is a known cipher suite.
+    return value == static_cast<std::uint8_t>(CipherSuite::CS_FISHCODE)
+        || value == static_cast<std::uint8_t>(CipherSuite::CS_AES128_CTR);
+}
+
+void fc::Cipher::Decrypt(std::span<std::uint8_t> bytes, const std::uint64_t offset) const noexcept {
+    if (suite == CipherSuite::CS_AES128_CTR) {
+        // Counter mode: decryption is the same XOR with the key stream.
+        aes.Crypt(bytes, offset);
+    } else {
+        // Blocks are independent of their position.
+        compiledKey.Decrypt(bytes);
+    }
+}
+
+void fc::Cipher::Encrypt(std::span<std::uint8_t> bytes, const std::uint64_t offset) const noexcept {
+    if (suite == CipherSuite::CS_AES128_CTR) {
+        // Counter mode: XOR with the key stream.
+        aes.Crypt(bytes, offset);
+    } else {
+        // Blocks are independent of their position.
+        compiledKey.Encrypt(bytes);
+    }
+}
+
+fc::KeyDelta::KeyDelta(const fc::CipherSuite newSuite, const fc::Key& oldKey, const fc::Key& newKey)
+: suite(newSuite), masks() {
+    // Counter mode: the delta is the XOR of both key streams.
+    if (suite == CipherSuite::CS_AES128_CTR) {
+        oldAes = Aes(oldKey);
+        newAes = Aes(newKey);
+        return;
+    }
+
+    // FishCode suite: E(x) = P(x) ^ mask, so the delta is the XOR of both masks (for every block length).
+    const CompiledKey oldCompiledKey(oldKey), newCompiledKey(newKey);
+    for (std::size_t realSize = 0; realSize <= Block::SIZE; realSize++) {
+        for (std::size_t index = 0; index < Block::SIZE; index++) {
+            masks[realSize][index] = oldCompiledKey.GetMask(realSize)[index] ^ newCompiledKey.GetMask(realSize)[index];
+        }
+    }
+}
+
+void fc::KeyDelta::Apply(std::span<std::uint8_t> bytes, const std::uint64_t offset) const noexcept {
+    // Counter mode: remove the old key stream and add the new one.
+    if (suite == CipherSuite::CS_AES128_CTR) {
+        oldAes.Crypt(bytes, offset);
+        newAes.Crypt(bytes, offset);
+        return;
+    }
+
+    // Calculate number of full blocks and size of the partial (last) block.
+    const auto total = bytes.size() / Block::SIZE;
+    const auto partial = bytes.size() % Block::SIZE;
+
+    // Combine full blocks with the delta (the compiler vectorizes this loop).
+    const auto& mask = masks[Block::SIZE];
+    for (std::size_t current = 0; current < total; current++) {
+        for (std::size_t index = 0; index < Block::SIZE; index++) {
+            bytes[current * Block::SIZE + index] ^= mask[index];
+        }
+    }
+
+    // Combine the partial block with the delta for its length.
+    for (std::size_t index = 0; index < partial; index++) {
+        bytes[total * Block::SIZE + index] ^= masks[partial][index];
+    }
+}
@@ -0,0 +1,87 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_CIPHER_HPP
+#define FISHCODE_CIPHER_HPP
+
+#include <array>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include "aes.hpp"
+#include "block.hpp"
+#include "compiled.hpp"
+#include "key.hpp"
+
+namespace fc {
+    enum class CipherSuite : std::uint8_t {
+        CS_FISHCODE = 0,
+        CS_AES128_CTR = 1
+    };
+
+    // Data transform selected by the cipher suite (the master key is the same for all suites).
+    class Cipher {
+    public:
+        Cipher();
+        Cipher(const CipherSuite newSuite, const Key& key);
+        Cipher(const Cipher& otherCipher) = default;
+        Cipher(Cipher&& otherCipher) noexcept = default;
+
+        ~Cipher() noexcept = default;
+
+        Cipher& operator=(const Cipher& otherCipher) = default;
+        Cipher& operator=(Cipher&& otherCipher) noexcept = default;
+
+        static bool IsSuite(const std::uint8_t value) noexcept;
+
+        inline CipherSuite GetSuite() const noexcept {
+            return suite;
+        }
+
+        // 'offset' is the position of 'bytes' in the data stream (a multiple of Block::SIZE for FishCode suite).
+        void Decrypt(std::span<std::uint8_t> bytes, const std::uint64_t offset) const noexcept;
+        void Encrypt(std::span<std::uint8_t> bytes, const std::uint64_t offset) const noexcept;
+    private:
+        CipherSuite suite;
+        CompiledKey compiledKey;
+        Aes aes;
+    };
+
+    // Maps data encrypted with one key directly to data encrypted with another key (same suite, one XOR pass).
+    class KeyDelta {
+    public:
+        KeyDelta(const CipherSuite newSuite, const Key& oldKey, const Key& newKey);
+        KeyDelta(const KeyDelta& otherDelta) = default;
+        KeyDelta(KeyDelta&& otherDelta) noexcept = default;
+
+        ~KeyDelta() noexcept = default;
+
+        KeyDelta& operator=(const KeyDelta& otherDelta) = default;
+        KeyDelta& operator=(KeyDelta&& otherDelta) noexcept = default;
+
+        // 'offset' is the position of 'bytes' in the data stream (a multiple of Block::SIZE for FishCode suite).
+        void Apply(std::span<std::uint8_t> bytes, const std::uint64_t offset) const noexcept;
+    private:
+        CipherSuite suite;
+        std::array<std::array<std::uint8_t, Block::SIZE>, Block::SIZE + 1> masks;
+        Aes oldAes, newAes;
+    };
+}
+
+#endif // FISHCODE_CIPHER_HPP
@@ -0,0 +1,193 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <cstdlib>
+#include <unistd.h>
+#include "cipher.hpp"
+#include "command.hpp"
+#include "error.hpp"
+#include "file.hpp"
+#include "inplace.hpp"
+#include "password.hpp"
+#include "pipe.hpp"
+#include "rewrap.hpp"
+#include "strings.hpp"
+
+namespace {
+    using CommandFunction = void (*)(const std::filesystem::path& fsPath);
+
+    struct Command {
+        const char* name;
+        CommandFunction Run;
+        bool isInPlace;
+        bool isPipe;
+    };
+
+    std::string GetPassword(const char* variable, const char* prompt) {
+        // Prefer the environment (scripts), then read a line from the standard input.
+        std::string passwordString;
+        if (const auto value = std::getenv(variable)) {
+            passwordString = value;
+        } else {
+            std::cerr << prompt << std::flush;
+            std::getline(std::cin, passwordString);
+        }
+
+        // Check the password (wherever it comes from).
+        fc::CheckPassword(passwordString);
+        return passwordString;
+    }
+
+    std::string GetPipePassword() {
+        // The standard input carries the data, so the password is taken from the environment only.
+        const auto value = std::getenv(fc::STR_PATTERN2);
+        if (value == nullptr) {
+            throw fc::error::InvalidPassword();
+        }
+
+        // Check the password.
+        fc::CheckPassword(value);
+        return value;
+    }
+
+    void AddPassword(const std::filesystem::path& fsPath) {
+        // Get one of the current passwords and the new one.
+        const auto password = GetPassword(fc::STR_PATTERN2, fc::STR_PROMPT4);
+        const auto newPassword = GetPassword(fc::STR_PATTERN3, fc::STR_PROMPT5);
+
+        // Fill a free key slot.
+        fc::AddPassword(fsPath, fc::Password(password), fc::Password(newPassword));
+    }
+
+    void ChangePassword(const std::filesystem::path& fsPath) {
+        // Get both passwords.
+        const auto oldPassword = GetPassword(fc::STR_PATTERN2, fc::STR_PROMPT4);
+        const auto newPassword = GetPassword(fc::STR_PATTERN3, fc::STR_PROMPT5);
+
+        // Replace the key slot of the old password.
+        fc::ChangePassword(fsPath, fc::Password(oldPassword), fc::Password(newPassword));
+    }
+
+    void DecryptPipe(const std::filesystem::path&) {
+        // Decrypt the standard input to the standard output.
+        const auto password = GetPipePassword();
+        fc::DecryptPipe(STDIN_FILENO, STDOUT_FILENO, fc::Password(password), fc::File::GetChunkSizeSetting());
+    }
+
+    void DecryptInPlace(const std::filesystem::path& fsPath) {
+        // Get the password.
+        const auto password = GetPassword(fc::STR_PATTERN2, fc::STR_PROMPT9);
+
+        // Decrypt the file (or finish its interrupted decryption).
+        fc::DecryptInPlace(fsPath, fc::Password(password), fc::File::GetChunkSizeSetting(), [](auto, auto) {
+            return true;
+        });
+    }
+
+    void EncryptInPlace(const std::filesystem::path& fsPath) {
+        // Get the password.
+        const auto password = GetPassword(fc::STR_PATTERN2, fc::STR_PROMPT9);
+
+        // Encrypt the file with the default cipher suite (or finish its interrupted encryption).
+        const auto suite = fc::CipherSuite::CS_FISHCODE;
+        fc::EncryptInPlace(fsPath, fc::Password(password), suite, fc::File::GetChunkSizeSetting(), [](auto, auto) {
+            return true;
+        });
+    }
+
+    void EncryptPipe(const std::filesystem::path&) {
+        // Encrypt the standard input to the standard output with the default cipher suite.
+        const auto password = GetPipePassword();
+        const auto suite = fc::CipherSuite::CS_FISHCODE;
+        fc::EncryptPipe(STDIN_FILENO, STDOUT_FILENO, fc::Password(password), suite, fc::File::GetChunkSizeSetting());
+    }
+
+    void RemovePassword(const std::filesystem::path& fsPath) {
+        // Get the password to remove.
+        const auto password = GetPassword(fc::STR_PATTERN2, fc::STR_PROMPT4);
+
+        // Free its key slot.
+        fc::RemovePassword(fsPath, fc::Password(password));
+    }
+
+    constexpr const Command COMMANDS[] = {
+        {fc::STR_COMMAND0, ChangePassword, false, false},
+        {fc::STR_COMMAND1, AddPassword, false, false},
+        {fc::STR_COMMAND2, RemovePassword, false, false},
+        {fc::STR_COMMAND3, EncryptInPlace, true, false},
+        {fc::STR_COMMAND4, DecryptInPlace, true, false},
+        {fc::STR_COMMAND5, EncryptPipe, false, true},
+        {fc::STR_COMMAND6, DecryptPipe, false, true}
+    };
+
+    const Command* FindCommand(int argc, char* argv[]) noexcept {
+        // The GUI is started without arguments.
+        if (argc < 2) {
+            return nullptr;
+        }
+
+        // Look up the operation by name.
+        for (const auto& command : COMMANDS) {
+            if (std::string_view(argv[1]) == command.name) {
+                return &command;
+            }
+        }
+        return nullptr;
+    }
+}
+
+bool fc::IsCommand(int argc, char* argv[]) noexcept {
+    return FindCommand(argc, argv) != nullptr;
+}
+
+int fc::RunCommand(int argc, char* argv[]) try {
+    // Check the command line.
+    const auto command = FindCommand(argc, argv);
+    if (command == nullptr || argc != (command->isPipe ? 2 : 3)) {
+        std::cerr << STR_USAGE0 << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Process the standard input (no file).
+    if (command->isPipe) {
+        command->Run(std::filesystem::path());
+        return EXIT_SUCCESS;
+    }
+    const std::filesystem::path fsPath(argv[2]);
+
+    // Check the file (in-place tasks check it themselves, so an interrupted task can be resumed).
+    if (!command->isInPlace) {
+        CheckInputFile(fsPath, true);
+    }
+
+    // Run the requested operation (key slots of a detached header are rewritten in its own file).
+    command->Run(command->isInPlace ? fsPath : File::GetHeaderFilePath(fsPath));
+    return EXIT_SUCCESS;
+} catch (const std::exception& ex) {
+    // Print error message to the terminal.
+    std::cerr << ex.what() << std::endl;
+
+    // Report the failure to the caller.
+    return EXIT_FAILURE;
+}
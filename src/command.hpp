@@ -0,0 +1,29 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_COMMAND_HPP
+#define FISHCODE_COMMAND_HPP
+
+namespace fc {
+    // Headless mode: the first argument names an operation that runs without the GUI.
+    bool IsCommand(int argc, char* argv[]) noexcept;
+    int RunCommand(int argc, char* argv[]);
+}
+
+#endif // FISHCODE_COMMAND_HPP
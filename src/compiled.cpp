@@ -0,0 +1,153 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <array>
+#include <span>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include "block.hpp"
+#include "compiled.hpp"
+#include "kernel.hpp"
+#include "key.hpp"
+
+namespace {
+    using TailFunction = void (*)(std::uint8_t* bytes, const std::uint8_t* mask) noexcept;
+
+    template<std::size_t INDEX>
+    inline void DecryptPair(std::uint8_t* bytes, const std::uint8_t* mask) noexcept {
+        // Remove the mask and swap bytes back.
+        const auto temp = bytes[INDEX];
+        bytes[INDEX] = bytes[INDEX + 1] ^ mask[INDEX + 1];
+        bytes[INDEX + 1] = temp ^ mask[INDEX];
+    }
+
+    template<std::size_t INDEX>
+    inline void EncryptPair(std::uint8_t* bytes, const std::uint8_t* mask) noexcept {
+        // Swap bytes and apply the mask.
+        const auto temp = bytes[INDEX];
+        bytes[INDEX] = bytes[INDEX + 1] ^ mask[INDEX];
+        bytes[INDEX + 1] = temp ^ mask[INDEX + 1];
+    }
+
+    template<std::size_t REAL_SIZE, std::size_t... PAIRS>
+    inline void DecryptFixed(std::uint8_t* bytes, const std::uint8_t* mask, std::index_sequence<PAIRS...>) noexcept {
+        // Process all pairs (fully unrolled).
+        (DecryptPair<2 * PAIRS>(bytes, mask), ...);
+
+        // Process the unpaired (last) byte.
+        if constexpr (REAL_SIZE % 2 != 0) {
+            bytes[REAL_SIZE - 1] ^= mask[REAL_SIZE - 1];
+        }
+    }
+
+    template<std::size_t REAL_SIZE, std::size_t... PAIRS>
+    inline void EncryptFixed(std::uint8_t* bytes, const std::uint8_t* mask, std::index_sequence<PAIRS...>) noexcept {
+        // Process all pairs (fully unrolled).
+        (EncryptPair<2 * PAIRS>(bytes, mask), ...);
+
+        // Process the unpaired (last) byte.
+        if constexpr (REAL_SIZE % 2 != 0) {
+            bytes[REAL_SIZE - 1] ^= mask[REAL_SIZE - 1];
+        }
+    }
+
+    template<std::size_t REAL_SIZE>
+    void DecryptTail(std::uint8_t* bytes, const std::uint8_t* mask) noexcept {
+        DecryptFixed<REAL_SIZE>(bytes, mask, std::make_index_sequence<REAL_SIZE / 2>());
+    }
+
+    template<std::size_t REAL_SIZE>
+    void EncryptTail(std::uint8_t* bytes, const std::uint8_t* mask) noexcept {
+        EncryptFixed<REAL_SIZE>(bytes, mask, std::make_index_sequence<REAL_SIZE / 2>());
+    }
+
+    template<std::size_t... REAL_SIZES>
+    constexpr std::array<TailFunction, sizeof...(REAL_SIZES)> MakeDecryptTable(std::index_sequence<REAL_SIZES...>) {
+        return {DecryptTail<REAL_SIZES>...};
+    }
+
+    template<std::size_t... REAL_SIZES>
+    constexpr std::array<TailFunction, sizeof...(REAL_SIZES)> MakeEncryptTable(std::index_sequence<REAL_SIZES...>) {
+        return {EncryptTail<REAL_SIZES>...};
+    }
+
+    // Jump tables: one specialized kernel for every block length (0 to 16 bytes).
+    constexpr auto decryptTable = MakeDecryptTable(std::make_index_sequence<fc::Block::SIZE + 1>());
+    constexpr auto encryptTable = MakeEncryptTable(std::make_index_sequence<fc::Block::SIZE + 1>());
+}
+
+fc::CompiledKey::CompiledKey() {
+    // Without a key every mask is empty (identity transform for XOR step).
+    for (auto& mask : masks) {
+        mask.fill(0);
+    }
+}
+
+fc::CompiledKey::CompiledKey(const fc::Key& key) {
+    // Each round is 'swap pairs, then XOR', so the whole cipher is affine: E(x) = P(x) ^ E(0).
+    for (std::size_t realSize = 0; realSize <= Block::SIZE; realSize++) {
+        // Create an empty (zero) block.
+        Block block;
+
+        // Run the reference rounds on it (with the required length): the result is the mask for this length.
+        block.Encrypt(key, realSize);
+
+        // Store the mask.
+        masks[realSize] = block.GetBytes();
+    }
+}
+
+void fc::CompiledKey::Decrypt(std::uint8_t* bytes, const std::size_t realSize) const noexcept {
+    // Use the kernel specialized for this block length.
+    decryptTable[realSize](bytes, masks[realSize].data());
+}
+
+void fc::CompiledKey::Decrypt(std::span<std::uint8_t> bytes) const noexcept {
+    // Calculate number of full blocks and size of the partial (last) block.
+    const auto total = bytes.size() / Block::SIZE;
+    const auto partial = bytes.size() % Block::SIZE;
+
+    // Decrypt all full blocks at once.
+    kernel::GetActive().Decrypt(bytes.data(), total, *this);
+
+    // Check if there is a partial block.
+    if (partial != 0) {
+        Decrypt(bytes.data() + total * Block::SIZE, partial);
+    }
+}
+
+void fc::CompiledKey::Encrypt(std::uint8_t* bytes, const std::size_t realSize) const noexcept {
+    // Use the kernel specialized for this block length.
+    encryptTable[realSize](bytes, masks[realSize].data());
+}
+
+void fc::CompiledKey::Encrypt(std::span<std::uint8_t> bytes) const noexcept {
+    // Calculate number of full blocks and size of the partial (last) block.
+    const auto total = bytes.size() / Block::SIZE;
+    const auto partial = bytes.size() % Block::SIZE;
+
+    // Encrypt all full blocks at once.
+    kernel::GetActive().Encrypt(bytes.data(), total, *this);
+
+    // Check if there is a partial block.
+    if (partial != 0) {
+        Encrypt(bytes.data() + total * Block::SIZE, partial);
+    }
+}
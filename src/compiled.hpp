@@ -0,0 +1,57 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_COMPILED_HPP
+#define FISHCODE_COMPILED_HPP
+
+#include <array>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include "block.hpp"
+#include "key.hpp"
+
+namespace fc {
+    // All 15 rounds of the cipher collapsed into one permutation (pair swap) and one mask per block length.
+    class CompiledKey {
+    public:
+        CompiledKey();
+        CompiledKey(const Key& key);
+        CompiledKey(const CompiledKey& otherCompiledKey) = default;
+        CompiledKey(CompiledKey&& otherCompiledKey) noexcept = default;
+
+        ~CompiledKey() noexcept = default;
+
+        CompiledKey& operator=(const CompiledKey& otherCompiledKey) = default;
+        CompiledKey& operator=(CompiledKey&& otherCompiledKey) noexcept = default;
+
+        inline const std::array<std::uint8_t, Block::SIZE>& GetMask(const std::size_t realSize) const noexcept {
+            return masks[realSize];
+        }
+
+        void Decrypt(std::uint8_t* bytes, const std::size_t realSize) const noexcept;
+        void Decrypt(std::span<std::uint8_t> bytes) const noexcept;
+        void Encrypt(std::uint8_t* bytes, const std::size_t realSize) const noexcept;
+        void Encrypt(std::span<std::uint8_t> bytes) const noexcept;
+    private:
+        std::array<std::array<std::uint8_t, Block::SIZE>, Block::SIZE + 1> masks;
+    };
+}
+
+#endif // FISHCODE_COMPILED_HPP
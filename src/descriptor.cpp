@@ -0,0 +1,319 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <ios>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <system_error>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "descriptor.hpp"
+#include "file.hpp"
+#include "key.hpp"
+#include "strings.hpp"
+
+namespace {
+    // Repeats 'transfer' (one system call for the rest of the bytes) until all bytes are transferred, the file ends
+    // or a transfer leaves the position unaligned. Returns the number of bytes transferred.
+    template<typename Transfer>
+    std::size_t TransferFull(
+        const std::size_t size,
+        const std::size_t alignment,
+        const char* name,
+        const Transfer& transfer
+    ) {
+        std::size_t done = 0;
+        while (done < size) {
+            const auto result = transfer(done);
+            if (result < 0) {
+                // Retry if the call was interrupted by a signal.
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                throw std::system_error(errno, std::generic_category(), name);
+            }
+            done += static_cast<std::size_t>(result);
+
+            // Check for the end of the file.
+            if (result == 0 || done % alignment != 0) {
+                break;
+            }
+        }
+        return done;
+    }
+
+    void CheckWritten(const std::size_t done, const std::size_t size, const char* name) {
+        // A write which transfers nothing can't be continued.
+        if (done != size) {
+            throw std::system_error(EIO, std::generic_category(), name);
+        }
+    }
+}
+
+std::size_t fc::ReadFull(const int fd, std::span<std::uint8_t> bytes) {
+    // Pipes return any amount of bytes.
+    return TransferFull(bytes.size(), 1, "read", [&](const std::size_t done) {
+        return read(fd, bytes.data() + done, bytes.size() - done);
+    });
+}
+
+std::size_t fc::ReadFullAt(
+    const int fd,
+    std::span<std::uint8_t> bytes,
+    const std::uint64_t offset,
+    const std::size_t alignment
+) {
+    // Large requests may be satisfied partially.
+    return TransferFull(bytes.size(), alignment, "pread", [&](const std::size_t done) {
+        return pread(fd, bytes.data() + done, bytes.size() - done, static_cast<off_t>(offset + done));
+    });
+}
+
+void fc::WriteFull(const int fd, std::span<const std::uint8_t> bytes) {
+    // Pipes accept any amount of bytes.
+    const auto done = TransferFull(bytes.size(), 1, "write", [&](const std::size_t done) {
+        return write(fd, bytes.data() + done, bytes.size() - done);
+    });
+    CheckWritten(done, bytes.size(), "write");
+}
+
+void fc::WriteFullAt(const int fd, std::span<const std::uint8_t> bytes, const std::uint64_t offset) {
+    // Large requests may be satisfied partially.
+    const auto done = TransferFull(bytes.size(), 1, "pwrite", [&](const std::size_t done) {
+        return pwrite(fd, bytes.data() + done, bytes.size() - done, static_cast<off_t>(offset + done));
+    });
+    CheckWritten(done, bytes.size(), "pwrite");
+}
+
+std::filesystem::path fc::CreateTemporary(
+    const std::filesystem::path& fsPath,
+    const std::function<bool(const std::filesystem::path& temporaryPath)>& create
+) {
+    for (;;) {
+        // Append a random suffix (64 bits, a name taken by another file is skipped).
+        const auto random = Key::Generate();
+        std::ostringstream suffix;
+        suffix << STR_PATTERN7 << '.' << std::hex << std::setfill('0');
+        for (std::size_t index = 0; index < 8; index++) {
+            suffix << std::setw(2) << static_cast<unsigned>(random.GetBytes()[index]);
+        }
+        auto temporaryPath = fsPath;
+        temporaryPath += suffix.str();
+
+        // Create the file under this name.
+        if (create(temporaryPath)) {
+            return temporaryPath;
+        }
+    }
+}
+
+void fc::SyncDirectory(const std::filesystem::path& fsPath) {
+    // Open the directory of the file.
+    const auto directory = fsPath.has_parent_path() ? fsPath.parent_path() : std::filesystem::path(".");
+    const auto fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), directory.string());
+    }
+
+    // Flush its entries to the disk.
+    const auto result = fsync(fd);
+    const auto error = errno;
+    close(fd);
+    if (result != 0) {
+        throw std::system_error(error, std::generic_category(), "fsync");
+    }
+}
+
+fc::DescriptorFile::DescriptorFile(const std::filesystem::path& fsPath, const fc::FileType type, const int flags)
+: isOutput(type == FileType::FT_OUTPUT), isDevice(false), position(0), deviceSize(0), window(0), releasedUntil(0),
+  writebackUntil(0) {
+    // Open or create the file.
+    if (isOutput) {
+        fd = open(fsPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | flags, 0666);
+    } else if (type == FileType::FT_UPDATE) {
+        fd = open(fsPath.c_str(), O_RDWR | O_CLOEXEC | flags);
+    } else {
+        fd = open(fsPath.c_str(), O_RDONLY | O_CLOEXEC | flags);
+    }
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), fsPath.string());
+    }
+
+    // Get size of the file (new output file is empty).
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        const auto error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "fstat");
+    }
+    size = static_cast<std::uint64_t>(status.st_size);
+
+    // Block devices have no size in the status, ask the driver (the output device is written from its start).
+    if (S_ISBLK(status.st_mode)) {
+        if (ioctl(fd, BLKGETSIZE64, &deviceSize) != 0) {
+            const auto error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "ioctl");
+        }
+        isDevice = true;
+        size = isOutput ? 0 : deviceSize;
+    }
+}
+
+fc::DescriptorFile::~DescriptorFile() noexcept {
+    // Drop the rest of the read bytes.
+    if (window != 0 && !isOutput) {
+        posix_fadvise(fd, static_cast<off_t>(releasedUntil), 0, POSIX_FADV_DONTNEED);
+    }
+
+    // Close the file.
+    close(fd);
+}
+
+void fc::DescriptorFile::SetCacheWindow(const std::uint64_t newWindow) noexcept {
+    // Start from the current position.
+    window = newWindow;
+    releasedUntil = position;
+    writebackUntil = position;
+}
+
+void fc::DescriptorFile::Advance(const std::uint64_t count) noexcept {
+    // Move the position (output file grows).
+    position += count;
+    if (isOutput) {
+        size = std::max(size, position);
+    }
+}
+
+std::size_t fc::DescriptorFile::Read(std::span<std::uint8_t> bytes) {
+    // Read from the current position.
+    const auto done = ReadAt(bytes, position);
+    Advance(done);
+
+    // Drop the bytes behind the position.
+    if (window != 0) {
+        ReleaseCache();
+    }
+    return done;
+}
+
+void fc::DescriptorFile::Write(std::span<const std::uint8_t> bytes) {
+    // Write at the current position.
+    WriteAt(bytes, position);
+    Advance(bytes.size());
+
+    // Limit the amount of dirty bytes.
+    if (window != 0) {
+        ReleaseCache();
+    }
+}
+
+void fc::DescriptorFile::Sync() {
+    // Flush the data (and the size) of the file to the disk.
+    if (fdatasync(fd) != 0) {
+        throw std::system_error(errno, std::generic_category(), "fdatasync");
+    }
+}
+
+void fc::DescriptorFile::Truncate(const std::uint64_t newSize) {
+    // Change size of the file.
+    if (ftruncate(fd, static_cast<off_t>(newSize)) != 0) {
+        throw std::system_error(errno, std::generic_category(), "ftruncate");
+    }
+    size = newSize;
+}
+
+std::size_t fc::DescriptorFile::ReadAt(std::span<std::uint8_t> bytes, const std::uint64_t offset) {
+    // Read until the end of the file.
+    return ReadFullAt(fd, bytes, offset);
+}
+
+void fc::DescriptorFile::WriteAt(std::span<const std::uint8_t> bytes, const std::uint64_t offset) {
+    // Write all bytes.
+    WriteFullAt(fd, bytes, offset);
+}
+
+void fc::DescriptorFile::ReleaseCache() {
+    // Check if the input file has a whole window of read bytes.
+    if (!isOutput) {
+        if (position - releasedUntil >= window) {
+            // Drop the read bytes (they are never read again).
+            const auto offset = static_cast<off_t>(releasedUntil);
+            const auto count = static_cast<off_t>(position - releasedUntil);
+            posix_fadvise(fd, offset, count, POSIX_FADV_DONTNEED);
+            releasedUntil = position;
+        }
+        return;
+    }
+
+    // Check if the output file has a whole window of dirty bytes.
+    if (position - writebackUntil < window) {
+        return;
+    }
+
+    // Wait for the writeback of the previous window and drop it (its pages are clean now).
+    if (writebackUntil > releasedUntil) {
+        const auto offset = static_cast<off64_t>(releasedUntil);
+        const auto count = static_cast<off64_t>(writebackUntil - releasedUntil);
+        const auto flags = SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER;
+        if (sync_file_range(fd, offset, count, flags) != 0) {
+            throw std::system_error(errno, std::generic_category(), "sync_file_range");
+        }
+        posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(count), POSIX_FADV_DONTNEED);
+        releasedUntil = writebackUntil;
+    }
+
+    // Start the writeback of this window (the task continues meanwhile).
+    const auto offset = static_cast<off64_t>(writebackUntil);
+    const auto count = static_cast<off64_t>(position - writebackUntil);
+    if (sync_file_range(fd, offset, count, SYNC_FILE_RANGE_WRITE) != 0) {
+        throw std::system_error(errno, std::generic_category(), "sync_file_range");
+    }
+    writebackUntil = position;
+}
+
+std::filesystem::path fc::CreateTemporaryFile(
+    const std::filesystem::path& fsPath,
+    std::unique_ptr<fc::DescriptorFile>& file
+) {
+    return CreateTemporary(fsPath, [&](const std::filesystem::path& temporaryPath) {
+        try {
+            // Never open an existing file.
+            file = std::make_unique<DescriptorFile>(temporaryPath, FileType::FT_OUTPUT, O_EXCL);
+            return true;
+        } catch (const std::system_error& ex) {
+            if (ex.code() == std::errc::file_exists) {
+                return false;
+            }
+            throw;
+        }
+    });
+}
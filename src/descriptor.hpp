@@ -0,0 +1,135 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_DESCRIPTOR_HPP
+#define FISHCODE_DESCRIPTOR_HPP
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include "backend.hpp"
+
+namespace fc {
+    enum class FileType;
+
+    // Full transfers through a descriptor: short transfers are continued and calls interrupted by a signal are
+    // retried. Reading stops only at the end of the file, or after a transfer which is not a multiple of 'alignment'
+    // (direct I/O can't continue from an unaligned offset). Return the number of bytes read.
+    std::size_t ReadFull(const int fd, std::span<std::uint8_t> bytes);
+    std::size_t ReadFullAt(
+        const int fd,
+        std::span<std::uint8_t> bytes,
+        const std::uint64_t offset,
+        const std::size_t alignment = 1
+    );
+    void WriteFull(const int fd, std::span<const std::uint8_t> bytes);
+    void WriteFullAt(const int fd, std::span<const std::uint8_t> bytes, const std::uint64_t offset);
+
+    // Calls 'create' with temporary names next to 'fsPath' ("FILE.tmp" and a random suffix) until it creates a new
+    // file ('create' returns false if the name is taken, an existing file is never touched), returns the name.
+    std::filesystem::path CreateTemporary(
+        const std::filesystem::path& fsPath,
+        const std::function<bool(const std::filesystem::path& temporaryPath)>& create
+    );
+
+    // Makes the creation, the renaming or the removal of 'fsPath' durable (flushes its directory to the disk).
+    void SyncDirectory(const std::filesystem::path& fsPath);
+
+    // File accessed through a POSIX descriptor with positional I/O (pread/pwrite).
+    class DescriptorFile : public Backend {
+    public:
+        // Extra open flags (e.g., O_DIRECT) are added to the default ones.
+        DescriptorFile(const std::filesystem::path& fsPath, const FileType type, const int flags = 0);
+        DescriptorFile(const DescriptorFile& otherFile) = delete;
+        DescriptorFile(DescriptorFile&& otherFile) noexcept = delete;
+
+        // Drops the cached bytes of the input file and closes the file.
+        ~DescriptorFile() noexcept override;
+
+        DescriptorFile& operator=(const DescriptorFile& otherFile) = delete;
+        DescriptorFile& operator=(DescriptorFile&& otherFile) noexcept = delete;
+
+        inline int GetDescriptor() const noexcept {
+            return fd;
+        }
+
+        inline std::uint64_t GetPosition() const noexcept {
+            return position;
+        }
+
+        inline std::uint64_t GetDeviceSize() const noexcept override {
+            return deviceSize;
+        }
+
+        inline std::uint64_t GetSize() const noexcept override {
+            return size;
+        }
+
+        inline bool IsDevice() const noexcept {
+            return isDevice;
+        }
+
+        // Keeps at most about 'newWindow' bytes of the file in the page cache (0 disables it): read bytes are dropped
+        // behind the position, written bytes are flushed by windows (the previous window is waited for).
+        void SetCacheWindow(const std::uint64_t newWindow) noexcept;
+
+        // Moves the position past bytes transferred by the caller (e.g., asynchronously).
+        void Advance(const std::uint64_t count) noexcept;
+
+        // Nothing is buffered (see Sync).
+        inline void Flush() override {
+        }
+
+        // Sequential I/O from the current position.
+        std::size_t Read(std::span<std::uint8_t> bytes) override;
+
+        inline void Skip(const std::uint64_t count) override {
+            Advance(count);
+        }
+        void Write(std::span<const std::uint8_t> bytes) override;
+
+        // Waits until the written bytes are on the disk.
+        void Sync();
+
+        // Sets the size of the file (e.g., drops padding written past the end).
+        void Truncate(const std::uint64_t newSize);
+
+        // Positional I/O (the position is not changed).
+        std::size_t ReadAt(std::span<std::uint8_t> bytes, const std::uint64_t offset);
+        void WriteAt(std::span<const std::uint8_t> bytes, const std::uint64_t offset);
+    private:
+        int fd;
+        bool isOutput, isDevice;
+        std::uint64_t size, position, deviceSize;
+        std::uint64_t window, releasedUntil, writebackUntil;
+
+        void ReleaseCache();
+    };
+
+    // Creates a new output file under a temporary name next to 'fsPath' (see CreateTemporary), returns the name.
+    std::filesystem::path CreateTemporaryFile(
+        const std::filesystem::path& fsPath,
+        std::unique_ptr<DescriptorFile>& file
+    );
+}
+
+#endif // FISHCODE_DESCRIPTOR_HPP
@@ -0,0 +1,207 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <new>
+#include <span>
+#include <system_error>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include "descriptor.hpp"
+#include "direct.hpp"
+#include "file.hpp"
+
+namespace {
+    constexpr auto ALIGNMENT = fc::AlignedBuffer::ALIGNMENT;
+
+    // Bytes of the sectors around the skipped bytes.
+    constexpr const std::array<std::uint8_t, ALIGNMENT> ZEROS = {};
+
+    // Checks if the bytes can be transferred with direct I/O (at least one whole sector).
+    bool IsAligned(const std::uint64_t offset, const std::uint8_t* data, const std::size_t size) noexcept {
+        return offset % ALIGNMENT == 0 && reinterpret_cast<std::uintptr_t>(data) % ALIGNMENT == 0 && size >= ALIGNMENT;
+    }
+
+    // Writes the bytes through the page cache (O_DIRECT is turned off for this write only).
+    void WriteBuffered(fc::DescriptorFile& file, std::span<const std::uint8_t> bytes, const std::uint64_t offset) {
+        const auto flags = fcntl(file.GetDescriptor(), F_GETFL);
+        if (flags < 0 || fcntl(file.GetDescriptor(), F_SETFL, flags & ~O_DIRECT) != 0) {
+            throw std::system_error(errno, std::generic_category(), "fcntl");
+        }
+        file.WriteAt(bytes, offset);
+        fcntl(file.GetDescriptor(), F_SETFL, flags);
+    }
+}
+
+fc::AlignedBuffer::AlignedBuffer(const std::size_t newSize)
+: data(static_cast<std::uint8_t*>(::operator new(newSize, std::align_val_t(ALIGNMENT)))), size(newSize) {}
+
+fc::AlignedBuffer::~AlignedBuffer() noexcept {
+    // Release the memory.
+    ::operator delete(data, std::align_val_t(ALIGNMENT));
+}
+
+fc::DirectFile::DirectFile(const std::filesystem::path& fsPath, const fc::FileType type)
+: file(fsPath, type, O_DIRECT), bounce(BOUNCE_SIZE), isOutput(type == FileType::FT_OUTPUT), position(0),
+  bounceOffset(0), bounceFill(0) {}
+
+fc::DirectFile::~DirectFile() noexcept try {
+    // Keep the tail of the output file (errors are reported by explicit Flush calls). A device is written only by
+    // explicit Flush calls of completed tasks (a failed task leaves no header at its start).
+    if (!file.IsDevice()) {
+        Flush();
+    }
+} catch (...) {
+    // Nothing can be done here.
+}
+
+void fc::DirectFile::Flush() {
+    // Check if it is the output file.
+    if (!isOutput) {
+        return;
+    }
+
+    // A device can't be truncated, so its tail is not padded (e.g., 512-byte sectors at the end).
+    if (file.IsDevice()) {
+        if (bounceFill != 0) {
+            WriteBuffered(file, std::span<const std::uint8_t>(bounce.GetData(), bounceFill), bounceOffset);
+        }
+
+        // Flush the tail and the cache of the device.
+        file.Sync();
+        return;
+    }
+
+    // Check if there are buffered bytes to write.
+    if (bounceFill == 0) {
+        return;
+    }
+
+    // Pad the bytes to the whole sector (the buffer is kept, so more bytes can be appended and flushed again).
+    const auto padded = (bounceFill + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    std::fill(bounce.GetData() + bounceFill, bounce.GetData() + padded, 0);
+    file.WriteAt(std::span<const std::uint8_t>(bounce.GetData(), padded), bounceOffset);
+
+    // Drop the padding.
+    file.Truncate(position);
+}
+
+std::size_t fc::DirectFile::Read(std::span<std::uint8_t> bytes) {
+    std::size_t done = 0;
+    while (done < bytes.size()) {
+        const auto rest = bytes.subspan(done);
+
+        // Copy the bytes which are in the bounce buffer.
+        if (position >= bounceOffset && position < bounceOffset + bounceFill) {
+            const auto start = static_cast<std::size_t>(position - bounceOffset);
+            const auto count = std::min(rest.size(), bounceFill - start);
+            std::copy_n(bounce.GetData() + start, count, rest.begin());
+            position += count;
+            done += count;
+            continue;
+        }
+
+        // Read whole sectors straight to the caller's memory.
+        if (IsAligned(position, rest.data(), rest.size())) {
+            const auto size = rest.size() - rest.size() % ALIGNMENT;
+            const auto count = ReadFullAt(file.GetDescriptor(), rest.first(size), position, ALIGNMENT);
+            position += count;
+            done += count;
+
+            // Check for the end of the file.
+            if (count < size) {
+                break;
+            }
+            continue;
+        }
+
+        // Read the sectors around the position to the bounce buffer.
+        bounceOffset = position - position % ALIGNMENT;
+        const auto buffer = std::span<std::uint8_t>(bounce.GetData(), bounce.GetSize());
+        bounceFill = ReadFullAt(file.GetDescriptor(), buffer, bounceOffset, ALIGNMENT);
+
+        // Check for the end of the file.
+        if (bounceOffset + bounceFill <= position) {
+            break;
+        }
+    }
+    return done;
+}
+
+void fc::DirectFile::Skip(const std::uint64_t count) {
+    // The input file is read from the new position.
+    if (!isOutput) {
+        position += count;
+        return;
+    }
+
+    // Fill the current sector with zeros (the bounce buffer always ends at a sector then).
+    const auto head = std::min<std::uint64_t>(count, (ALIGNMENT - position % ALIGNMENT) % ALIGNMENT);
+    Write(std::span<const std::uint8_t>(ZEROS).first(static_cast<std::size_t>(head)));
+    if (head == count) {
+        return;
+    }
+
+    // Write the buffered sectors and move over the whole sectors.
+    if (bounceFill != 0) {
+        file.WriteAt(std::span<const std::uint8_t>(bounce.GetData(), bounceFill), bounceOffset);
+        bounceFill = 0;
+    }
+    const auto rest = count - head;
+    position += rest - rest % ALIGNMENT;
+
+    // Start the last partial sector with zeros.
+    Write(std::span<const std::uint8_t>(ZEROS).first(static_cast<std::size_t>(rest % ALIGNMENT)));
+}
+
+void fc::DirectFile::Write(std::span<const std::uint8_t> bytes) {
+    std::size_t done = 0;
+    while (done < bytes.size()) {
+        const auto rest = bytes.subspan(done);
+
+        // Write whole sectors straight from the caller's memory.
+        if (bounceFill == 0 && IsAligned(position, rest.data(), rest.size())) {
+            const auto count = rest.size() - rest.size() % ALIGNMENT;
+            file.WriteAt(rest.first(count), position);
+            position += count;
+            done += count;
+            continue;
+        }
+
+        // Append the bytes to the bounce buffer (it always starts at a sector).
+        if (bounceFill == 0) {
+            bounceOffset = position;
+        }
+        const auto count = std::min(rest.size(), bounce.GetSize() - bounceFill);
+        std::copy_n(rest.begin(), count, bounce.GetData() + bounceFill);
+        bounceFill += count;
+        position += count;
+        done += count;
+
+        // Write the full bounce buffer.
+        if (bounceFill == bounce.GetSize()) {
+            file.WriteAt(std::span<const std::uint8_t>(bounce.GetData(), bounceFill), bounceOffset);
+            bounceFill = 0;
+        }
+    }
+}
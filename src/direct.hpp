@@ -0,0 +1,107 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_DIRECT_HPP
+#define FISHCODE_DIRECT_HPP
+
+#include <filesystem>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include "backend.hpp"
+#include "descriptor.hpp"
+
+namespace fc {
+    enum class FileType;
+
+    // Memory aligned for direct I/O.
+    class AlignedBuffer {
+    public:
+        // Alignment of addresses, sizes and file offsets (covers both 512-byte and 4 KiB sectors).
+        static constexpr const std::size_t ALIGNMENT = 4096;
+
+        explicit AlignedBuffer(const std::size_t newSize);
+        AlignedBuffer(const AlignedBuffer& otherBuffer) = delete;
+        AlignedBuffer(AlignedBuffer&& otherBuffer) noexcept = delete;
+
+        ~AlignedBuffer() noexcept;
+
+        AlignedBuffer& operator=(const AlignedBuffer& otherBuffer) = delete;
+        AlignedBuffer& operator=(AlignedBuffer&& otherBuffer) noexcept = delete;
+
+        inline std::uint8_t* GetData() const noexcept {
+            return data;
+        }
+
+        inline std::size_t GetSize() const noexcept {
+            return size;
+        }
+    private:
+        std::uint8_t* data;
+        std::size_t size;
+    };
+
+    // File accessed with O_DIRECT (bypassing the page cache). Aligned requests go straight to the disk, the rest
+    // (the header and the data next to it, the last partial sector) is assembled in a bounce buffer.
+    class DirectFile : public Backend {
+    public:
+        static constexpr const std::size_t BOUNCE_SIZE = 1 << 20;
+
+        // Throws std::system_error (EINVAL if the file system does not support direct I/O).
+        DirectFile(const std::filesystem::path& fsPath, const FileType type);
+        DirectFile(const DirectFile& otherFile) = delete;
+        DirectFile(DirectFile&& otherFile) noexcept = delete;
+
+        // Flushes the output file (errors are ignored, a device is not flushed) and closes the file.
+        ~DirectFile() noexcept override;
+
+        DirectFile& operator=(const DirectFile& otherFile) = delete;
+        DirectFile& operator=(DirectFile&& otherFile) noexcept = delete;
+
+        inline std::uint64_t GetDeviceSize() const noexcept override {
+            return file.GetDeviceSize();
+        }
+
+        inline std::uint64_t GetSize() const noexcept override {
+            return file.GetSize();
+        }
+
+        // Writes the buffered tail of the output file (padded to the sector) and trims the padding. The tail of
+        // a block device is written through the page cache instead and the device is synced.
+        void Flush() override;
+
+        std::size_t Read(std::span<std::uint8_t> bytes) override;
+
+        // Moves the position past 'count' bytes. Skipped output bytes are a hole, but the rest of the sectors around
+        // the hole are written as zeros.
+        void Skip(const std::uint64_t count) override;
+        void Write(std::span<const std::uint8_t> bytes) override;
+    private:
+        DescriptorFile file;
+        AlignedBuffer bounce;
+        bool isOutput;
+        std::uint64_t position;
+
+        // Bytes of the file at the aligned offset 'bounceOffset' kept in the bounce buffer.
+        std::uint64_t bounceOffset;
+        std::size_t bounceFill;
+    };
+}
+
+#endif // FISHCODE_DIRECT_HPP
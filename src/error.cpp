@@ -18,10 +18,14 @@
 */
 
 #include <filesystem>
+#include <ios>
 #include <string>
+#include <system_error>
+#include <cstdint>
 #include "error.hpp"
 #include "file.hpp"
-#include "key.hpp"
+#include "header.hpp"
+#include "inplace.hpp"
 #include "password.hpp"
 
 const char* fc::error::InvalidFileIO::what() const noexcept {
@@ -40,25 +44,77 @@ const char* fc::error::InvalidPassword::what() const noexcept {
     return "Invalid password!";
 }
 
-void fc::CheckFileIO(const std::filesystem::path& ifPath, const std::filesystem::path& ofPath) {
-  // Check if pathes are not equivalent.
-  if (std::filesystem::exists(ifPath) && std::filesystem::exists(ofPath)) {
-    if (std::filesystem::equivalent(ifPath, ofPath)) {
+const char* fc::error::LastKeySlot::what() const noexcept {
+    return "Cannot remove the last password of the file!";
+}
+
+const char* fc::error::LegacyKeySlots::what() const noexcept {
+    return "The key slots of the file have an old format, rekey the file first!";
+}
+
+const char* fc::error::NoFreeKeySlot::what() const noexcept {
+    return "No free key slot in the file!";
+}
+
+const char* fc::error::NoFreeSpace::what() const noexcept {
+    return "Not enough free space for the output file!";
+}
+
+const char* fc::error::UncheckedPassword::what() const noexcept {
+    return "The password of this file cannot be checked (old file format)!";
+}
+
+const char* fc::error::UnfinishedTask::what() const noexcept {
+    return "The file has an unfinished in-place task!";
+}
+
+void fc::CheckFileIO(
+    const std::filesystem::path& ifPath,
+    const std::filesystem::path& ofPath,
+    const bool isInPlaceAllowed
+) {
+  // Check if pathes are not equivalent (unless the file is transformed in place, a device can't change its size).
+  if (IsSameFile(ifPath, ofPath)) {
+    if (!isInPlaceAllowed || std::filesystem::is_block_file(ofPath)) {
       // Invalid file I/O.
       throw error::InvalidFileIO();
     }
   }
 }
 
+void fc::CheckFreeSpace(const std::filesystem::path& ofPath, const std::uintmax_t bytesToWrite) {
+    // Get free space of the file system (statvfs), the check is skipped if it is unknown.
+    std::error_code code;
+    const auto info = std::filesystem::space(ofPath, code);
+
+    // Check if the rest of the output file fits.
+    if (!code && info.available < bytesToWrite) {
+        // Not enough free space.
+        throw error::NoFreeSpace();
+    }
+}
+
 void fc::CheckInputFile(const std::filesystem::path& ifPath, const bool isEncrypted) {
-    // Check if it is path to a regular file.
-    if (std::filesystem::is_regular_file(ifPath)) {
+    // The file of an interrupted in-place task is neither plain nor encrypted.
+    if (HasJournal(ifPath)) {
+        throw error::UnfinishedTask();
+    }
+
+    // Check if it is path to a regular file or a block device.
+    if (std::filesystem::is_regular_file(ifPath) || std::filesystem::is_block_file(ifPath)) {
         // Open the file.
-        const File inputFile(ifPath, FileType::FT_INPUT);
+        File inputFile(ifPath, FileType::FT_INPUT);
 
         // Check file size.
         if (isEncrypted) {
-            if (inputFile.GetSize() < Key::SIZE + 1) {
+            // Read (and check) the header.
+            const auto header = inputFile.ReadHeader();
+
+            // There must be at least one byte of data after the header (a detached header is in its own file, a sparse
+            // file may have holes only).
+            const auto headerSize = inputFile.IsHeaderDetached() ? 0 : header.GetSize();
+            const auto dataSize = header.GetExtents().IsSparse() ? 0 : 1;
+            if (inputFile.GetSize() < static_cast<std::streamsize>(headerSize + dataSize)) {
                 // Invalid input file.
                 throw error::InvalidInputFile();
             }
@@ -74,6 +130,14 @@ void fc::CheckInputFile(const std::filesystem::path& ifPath, const bool isEncryp
     }
 }
 
+void fc::CheckInputPassword(const std::filesystem::path& ifPath, const std::string& passwordString) {
+    // Open the file.
+    File inputFile(ifPath, FileType::FT_INPUT);
+
+    // Decrypt the key (throws if the password does not match the check value).
+    inputFile.ReadHeader().UnwrapKey(Password(passwordString));
+}
+
 void fc::CheckOutputFile(const std::filesystem::path& ofPath) {
     // Check if path is not empty.
     if (ofPath.empty()) {
@@ -83,8 +147,8 @@ void fc::CheckOutputFile(const std::filesystem::path& ofPath) {
 
     // Check if path points to the existing file.
     if (std::filesystem::exists(ofPath)) {
-        // Check if it is regular file.
-        if (!std::filesystem::is_regular_file(ofPath)) {
+        // Check if it is regular file or a block device.
+        if (!std::filesystem::is_regular_file(ofPath) && !std::filesystem::is_block_file(ofPath)) {
             // Invalid output file.
             throw error::InvalidOutputFile();
         }
@@ -21,7 +21,9 @@
 #define FISHCODE_ERROR_HPP
 
 #include <exception>
+#include <filesystem>
 #include <string>
+#include <cstdint>
 #include "file.hpp"
 #include "password.hpp"
 
@@ -82,10 +84,100 @@ namespace fc {
 
             const char* what() const noexcept override;
         };
+
+        class LastKeySlot : public std::exception {
+        public:
+            LastKeySlot() noexcept = default;
+            LastKeySlot(const LastKeySlot& other) = default;
+            LastKeySlot(LastKeySlot&& other) noexcept = default;
+
+            ~LastKeySlot() noexcept = default;
+
+            LastKeySlot& operator=(const LastKeySlot& other) = default;
+            LastKeySlot& operator=(LastKeySlot&& other) noexcept = default;
+
+            const char* what() const noexcept override;
+        };
+
+        class LegacyKeySlots : public std::exception {
+        public:
+            LegacyKeySlots() noexcept = default;
+            LegacyKeySlots(const LegacyKeySlots& other) = default;
+            LegacyKeySlots(LegacyKeySlots&& other) noexcept = default;
+
+            ~LegacyKeySlots() noexcept = default;
+
+            LegacyKeySlots& operator=(const LegacyKeySlots& other) = default;
+            LegacyKeySlots& operator=(LegacyKeySlots&& other) noexcept = default;
+
+            const char* what() const noexcept override;
+        };
+
+        class NoFreeKeySlot : public std::exception {
+        public:
+            NoFreeKeySlot() noexcept = default;
+            NoFreeKeySlot(const NoFreeKeySlot& other) = default;
+            NoFreeKeySlot(NoFreeKeySlot&& other) noexcept = default;
+
+            ~NoFreeKeySlot() noexcept = default;
+
+            NoFreeKeySlot& operator=(const NoFreeKeySlot& other) = default;
+            NoFreeKeySlot& operator=(NoFreeKeySlot&& other) noexcept = default;
+
+            const char* what() const noexcept override;
+        };
+
+        class NoFreeSpace : public std::exception {
+        public:
+            NoFreeSpace() noexcept = default;
+            NoFreeSpace(const NoFreeSpace& other) = default;
+            NoFreeSpace(NoFreeSpace&& other) noexcept = default;
+
+            ~NoFreeSpace() noexcept = default;
+
+            NoFreeSpace& operator=(const NoFreeSpace& other) = default;
+            NoFreeSpace& operator=(NoFreeSpace&& other) noexcept = default;
+
+            const char* what() const noexcept override;
+        };
+
+        class UncheckedPassword : public std::exception {
+        public:
+            UncheckedPassword() noexcept = default;
+            UncheckedPassword(const UncheckedPassword& other) = default;
+            UncheckedPassword(UncheckedPassword&& other) noexcept = default;
+
+            ~UncheckedPassword() noexcept = default;
+
+            UncheckedPassword& operator=(const UncheckedPassword& other) = default;
+            UncheckedPassword& operator=(UncheckedPassword&& other) noexcept = default;
+
+            const char* what() const noexcept override;
+        };
+
+        class UnfinishedTask : public std::exception {
+        public:
+            UnfinishedTask() noexcept = default;
+            UnfinishedTask(const UnfinishedTask& other) = default;
+            UnfinishedTask(UnfinishedTask&& other) noexcept = default;
+
+            ~UnfinishedTask() noexcept = default;
+
+            UnfinishedTask& operator=(const UnfinishedTask& other) = default;
+            UnfinishedTask& operator=(UnfinishedTask&& other) noexcept = default;
+
+            const char* what() const noexcept override;
+        };
     }
 
-    void CheckFileIO(const std::filesystem::path& ifPath, const std::filesystem::path& ofPath);
+    void CheckFileIO(
+        const std::filesystem::path& ifPath,
+        const std::filesystem::path& ofPath,
+        const bool isInPlaceAllowed = false
+    );
+    void CheckFreeSpace(const std::filesystem::path& outputFilePath, const std::uintmax_t bytesToWrite);
     void CheckInputFile(const std::filesystem::path& inputFilePath, const bool isEncrypted);
+    void CheckInputPassword(const std::filesystem::path& inputFilePath, const std::string& passwordString);
     void CheckOutputFile(const std::filesystem::path& outputFilePath);
     void CheckPassword(const std::string& passwordString);
 }
@@ -36,6 +36,8 @@ namespace fc {
             ID_CHOOSE,
             ID_DECRYPT,
             ID_ENCRYPT,
+            ID_PASSWORD,
+            ID_REKEY,
             ID_SET
         };
 
@@ -47,6 +49,11 @@ namespace fc {
             ID_FRAME = ID_READY + 1
         };
 
+        enum MenuItemID {
+            ID_SUITE_FISHCODE = ID_FRAME + 1,
+            ID_SUITE_AES
+        };
+
         class TaskException : public wxEvent {
         public:
             TaskException(const int newID, const std::exception& ex) noexcept;
@@ -17,84 +17,471 @@
 ** with FishCode. If not, see <https://www.gnu.org/licenses/>.
 */
 
-#include <array>
+#include <algorithm>
 #include <filesystem>
 #include <ios>
-#include <utility>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <vector>
 #include <cstddef>
 #include <cstdint>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include "anonymous.hpp"
 #include "block.hpp"
+#include "descriptor.hpp"
+#include "direct.hpp"
+#include "error.hpp"
 #include "file.hpp"
-#include "key.hpp"
+#include "header.hpp"
+#include "mapping.hpp"
+#include "sparse.hpp"
+#include "stream.hpp"
+#include "strings.hpp"
+#include "uring.hpp"
 
-fc::File::File() {
-    // Now its file stream is not valid (no real file).
-    stream.setstate(std::ios::badbit | std::ios::eofbit);
+namespace {
+    // Zeros written to a device which can't punch holes.
+    constexpr const std::size_t ZERO_BUFFER_SIZE = 1 << 20;
+
+    void PunchHole(fc::DescriptorFile& file, const std::uint64_t offset, const std::uint64_t count) {
+        // Free the blocks of the hole (e.g., zeros written around it by the direct backend).
+        const auto flags = FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE;
+        if (fallocate(file.GetDescriptor(), flags, static_cast<off_t>(offset), static_cast<off_t>(count)) == 0) {
+            return;
+        }
+
+        // Bytes of a regular file which were not written are zeros anyway.
+        if (!file.IsDevice()) {
+            return;
+        }
+
+        // Write zeros over the old data of the device.
+        const auto zerosSize = static_cast<std::size_t>(std::min<std::uint64_t>(count, ZERO_BUFFER_SIZE));
+        const std::vector<std::uint8_t> zeros(zerosSize);
+        for (std::uint64_t done = 0; done < count;) {
+            const auto size = static_cast<std::size_t>(std::min<std::uint64_t>(count - done, zeros.size()));
+            file.WriteAt(std::span<const std::uint8_t>(zeros).first(size), offset + done);
+            done += size;
+        }
+    }
+
+    void RecreateHoles(const std::filesystem::path& fsPath, const fc::ExtentMap& extents) {
+        // Open the file once more (the stream has no descriptor).
+        fc::DescriptorFile file(fsPath, fc::FileType::FT_UPDATE);
+
+        // Set the size of a regular file (the last hole is not written).
+        if (!file.IsDevice()) {
+            file.Truncate(extents.GetSize());
+        }
+
+        // Punch the holes between the extents and after the last one.
+        std::uint64_t offset = 0;
+        for (const auto& extent : extents.GetExtents()) {
+            if (extent.offset > offset) {
+                PunchHole(file, offset, extent.offset - offset);
+            }
+            offset = extent.offset + extent.size;
+        }
+        if (offset < extents.GetSize()) {
+            PunchHole(file, offset, extents.GetSize() - offset);
+        }
+    }
+
+    void Preallocate(const std::filesystem::path& fsPath, const std::uint64_t totalSize) {
+        // Open the file once more (the stream has no descriptor).
+        const auto fd = open(fsPath.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+
+        // Allocate all blocks of the file (its size is still set by the writes).
+        const auto result = fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(totalSize));
+        const auto error = errno;
+        close(fd);
+
+        // Only lack of space is an error (the file system may not support preallocation).
+        if (result != 0 && error == ENOSPC) {
+            throw fc::error::NoFreeSpace();
+        }
+    }
+}
 
-    // Now it is empty file.
+fc::File::File() {
+    // Now it is empty file (no real file).
     size = 0;
 }
 
-fc::File::File(const std::filesystem::path& newFSPath, const fc::FileType type)
-: fsPath(newFSPath) {
-    if (type == FileType::FT_INPUT) {
-        // Open a file.
-        stream.open(newFSPath, std::ios::in | std::ios::binary | std::ios::ate);
+fc::File::File(
+    const std::filesystem::path& newFSPath,
+    const fc::FileType type,
+    const fc::FileBackend newBackend,
+    const std::filesystem::path& newHeaderPath
+) : fsPath(newFSPath), headerPath(newHeaderPath), isOutput(type == FileType::FT_OUTPUT) {
+    // Check if the file is a block device (the streams and the mappings don't know its size).
+    isDevice = std::filesystem::is_block_file(newFSPath);
+
+    // Create the output file without a name, it gets the name when the task is completed (see Link).
+    if (type == FileType::FT_OUTPUT && !isDevice) {
+        try {
+            anonymous = std::make_unique<AnonymousFile>(newFSPath);
+        } catch (const std::system_error&) {
+            // The file system has no unnamed files, so the output file is created under its name.
+        }
+    }
+    const auto openPath = anonymous ? anonymous->GetPath() : newFSPath;
 
-        // Calculate size of the file.
-        size = static_cast<std::streamsize>(stream.tellg());
+    // Try to open the file for direct I/O (without its support in the file system the stream is used instead).
+    if (newBackend == FileBackend::FB_DIRECT || isDevice) {
+        try {
+            backend = std::make_unique<DirectFile>(openPath, type);
+        } catch (const std::system_error& ex) {
+            if (ex.code() != std::errc::invalid_argument) {
+                throw;
+            }
+        }
+    }
+
+    // Try to map the output file (without preallocation in the file system the stream is used instead).
+    if (newBackend == FileBackend::FB_MMAP && type == FileType::FT_OUTPUT && !isDevice) {
+        try {
+            auto mappedFile = std::make_unique<MappedFile>(openPath);
+            mapping = mappedFile.get();
+            backend = std::move(mappedFile);
+        } catch (const std::system_error& ex) {
+            if (ex.code() != std::errc::operation_not_supported) {
+                throw;
+            }
+        }
+    }
 
-        // Rewind the stream.
-        stream.seekg(std::ios::beg);
+    // Open the file with the selected backend.
+    if (backend) {
+        // The file is accessed with direct I/O or mapped (nothing else to open).
+    } else if (isDevice) {
+        // Open the device without direct I/O (its driver doesn't support it).
+        backend = std::make_unique<DescriptorFile>(openPath, type);
+    } else if (newBackend == FileBackend::FB_MMAP && type == FileType::FT_INPUT) {
+        // Read the input file straight into the mapped output file (a mapped input file kills the process with
+        // SIGBUS if it is truncated during the task).
+        backend = std::make_unique<DescriptorFile>(openPath, type);
+    } else if (newBackend == FileBackend::FB_URING && Ring::IsSupported()) {
+        // Open or create the file (without io_uring in the kernel the stream is used instead).
+        auto descriptorFile = std::make_unique<DescriptorFile>(openPath, type);
+        descriptor = descriptorFile.get();
+        backend = std::move(descriptorFile);
+        isAsync = true;
+    } else if (newBackend == FileBackend::FB_FADVISE) {
+        // Open or create the file and limit its bytes in the page cache.
+        auto descriptorFile = std::make_unique<DescriptorFile>(openPath, type);
+        descriptorFile->SetCacheWindow(GetCacheWindowSetting());
+        backend = std::move(descriptorFile);
     } else {
-        // Create a file.
-        stream.open(newFSPath, std::ios::out | std::ios::binary);
+        // Open or create a file.
+        backend = std::make_unique<StreamFile>(openPath, type);
+    }
+
+    // Get size of the file (new output file is empty, output device is written from its start).
+    size = static_cast<std::streamsize>(backend->GetSize());
+    deviceSize = backend->GetDeviceSize();
+}
+
+fc::FileBackend fc::File::GetBackendSetting() noexcept {
+    // Check if the backend is configured.
+    const auto value = std::getenv(STR_PATTERN5);
+    if (value != nullptr && std::string_view(value) == "mmap") {
+        return FileBackend::FB_MMAP;
+    }
+    if (value != nullptr && std::string_view(value) == "uring") {
+        return FileBackend::FB_URING;
+    }
+    if (value != nullptr && std::string_view(value) == "direct") {
+        return FileBackend::FB_DIRECT;
+    }
+    if (value != nullptr && std::string_view(value) == "fadvise") {
+        return FileBackend::FB_FADVISE;
+    }
+
+    // Use the standard stream by default.
+    return FileBackend::FB_STREAM;
+}
+
+std::uint64_t fc::File::GetCacheWindowSetting() noexcept {
+    // Check if the window is configured.
+    const auto value = std::getenv(STR_PATTERN8);
+    if (value == nullptr) {
+        return DEFAULT_CACHE_WINDOW;
+    }
+
+    // Convert MiB to bytes (invalid values select the default window).
+    const auto mebibytes = std::strtoull(value, nullptr, 10);
+    if (mebibytes == 0) {
+        return DEFAULT_CACHE_WINDOW;
+    }
+    return std::clamp<std::uint64_t>(mebibytes, MIN_CACHE_WINDOW >> 20, MAX_CACHE_WINDOW >> 20) << 20;
+}
+
+std::size_t fc::File::GetChunkSizeSetting() noexcept {
+    // Check if the chunk size is configured.
+    const auto value = std::getenv(STR_PATTERN4);
+    if (value == nullptr) {
+        return DEFAULT_CHUNK_SIZE;
+    }
+
+    // Convert MiB to bytes (invalid values select the default size).
+    const auto mebibytes = std::strtoul(value, nullptr, 10);
+    if (mebibytes == 0) {
+        return DEFAULT_CHUNK_SIZE;
+    }
+    return std::clamp<std::size_t>(mebibytes << 20, MIN_CHUNK_SIZE, MAX_CHUNK_SIZE);
+}
+
+std::filesystem::path fc::File::GetHeaderFilePath(const std::filesystem::path& fsPath) {
+    // Key slots of a detached header are in its own file.
+    const auto detachedPath = GetHeaderSetting();
+    return detachedPath.empty() ? fsPath : detachedPath;
+}
+
+std::filesystem::path fc::File::GetHeaderSetting() {
+    // Check if the header is detached.
+    const auto value = std::getenv(STR_PATTERN9);
+    if (value == nullptr) {
+        return std::filesystem::path();
+    }
+    return std::filesystem::path(value);
+}
+
+bool fc::File::GetSparseSetting() noexcept {
+    // Check if the holes are skipped.
+    const auto value = std::getenv(STR_PATTERN10);
+    return value != nullptr && std::string_view(value) == "1";
+}
+
+fc::ExtentMap fc::File::FindExtents() const {
+    // Find the holes of a regular file.
+    return ExtentMap::Find(fsPath);
+}
+
+void fc::File::Flush() {
+    // Skip the last hole of a sparse file (the backends trim the output file to their position).
+    if (IsSparse() && position < extents.GetSize()) {
+        backend->Skip(extents.GetSize() - position);
+        position = extents.GetSize();
+    }
 
-        // Now it is empty file.
-        size = 0;
+    // Write the buffered bytes (e.g., the last partial sector of the direct backend).
+    if (backend) {
+        backend->Flush();
     }
+
+    // Recreate the holes of a sparse file.
+    if (IsSparse()) {
+        RecreateHoles(GetDataPath(), extents);
+    }
+
+    // Check if there is a detached header to write.
+    if (detachedHeader.empty()) {
+        return;
+    }
+
+    // Write the header to a new temporary file and flush it to the disk.
+    std::unique_ptr<DescriptorFile> headerFile;
+    const auto temporaryPath = CreateTemporaryFile(headerPath, headerFile);
+    headerFile->Write(detachedHeader);
+    headerFile->Sync();
+    headerFile.reset();
+
+    // Replace the header file at once (a crash leaves either the old or the new header).
+    std::filesystem::rename(temporaryPath, headerPath);
+    SyncDirectory(headerPath);
+    detachedHeader.clear();
+}
+
+void fc::File::Link() {
+    // Check if the output file has no name yet.
+    if (!anonymous) {
+        return;
+    }
+
+    // Give the file its name (the data is flushed to the disk first).
+    anonymous->Link(fsPath);
+    anonymous.reset();
+}
+
+std::span<std::uint8_t> fc::File::MapWriteChunk(const std::size_t count) {
+    // Get the next bytes of the mapped file.
+    const auto bytes = mapping->MapWriteChunk(count);
+
+    // Update file size.
+    size += static_cast<std::streamsize>(count);
+
+    // Return the bytes.
+    return bytes;
 }
 
 fc::Block fc::File::ReadBlock(const std::streamsize bytesToRead) {
-    // Create storage for the block (raw bytes).
-    std::array<std::uint8_t, Block::SIZE> bytes;
+    // Create storage for the block.
+    Block block;
 
     // Read block (raw bytes) from the file.
-    stream.read(reinterpret_cast<char*>(bytes.data()), bytesToRead);
+    ReadChunk(std::span<std::uint8_t>(block.GetData(), static_cast<std::size_t>(bytesToRead)));
 
-    // Create a real block object and return it.
-    return Block(std::move(bytes), static_cast<std::size_t>(bytesToRead));
+    // Return the block (its real size is known by the caller).
+    return block;
 }
 
-fc::Key fc::File::ReadKey() {
-    // Create storage for the key (raw bytes).
-    std::array<std::uint8_t, Key::SIZE> bytes;
+std::size_t fc::File::ReadChunk(std::span<std::uint8_t> chunk) {
+    // Read the whole chunk (a file without holes).
+    if (!IsSparse()) {
+        return backend->Read(chunk);
+    }
 
-    // Read key (raw bytes) from the file.
-    stream.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(Key::SIZE));
+    // Read the data extents only (the holes are skipped).
+    std::size_t done = 0;
+    while (done < chunk.size() && extentIndex < extents.GetExtents().size()) {
+        const auto count = SeekExtent(chunk.size() - done);
+        const auto result = backend->Read(chunk.subspan(done, count));
+        AdvanceExtent(result);
+        done += result;
 
-    // Create a real key object and return it.
-    return Key(std::move(bytes));
+        // Check for the end of the file (it has become shorter than its extents).
+        if (result < count) {
+            break;
+        }
+    }
+    return done;
 }
 
-void fc::File::WriteBlock(const fc::Block& block) {
-    // Get a copy of the block bytes.
-    const auto bytes = block.GetBytes();
+fc::Header fc::File::ReadHeader() {
+    // Read the detached header from its own file.
+    if (IsHeaderDetached()) {
+        File headerFile(headerPath, FileType::FT_INPUT, FileBackend::FB_STREAM, std::filesystem::path());
+        return headerFile.ReadHeader();
+    }
 
-    // Write these bytes to the file.
-    stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(block.GetRealSize()));
+    // Read the fixed part of the header (or the whole legacy header).
+    std::vector<std::uint8_t> bytes(Header::FIXED_SIZE);
+    const auto fixedSize = ReadChunk(bytes);
 
-    // Update file size.
-    size += static_cast<std::streamsize>(block.GetRealSize());
+    // Check if the file is long enough.
+    if (fixedSize != Header::FIXED_SIZE) {
+        throw error::InvalidInputFile();
+    }
+
+    // Read the rest of the header (the size is checked before the memory is allocated).
+    const auto headerSize = Header::GetSerializedSize(bytes);
+    if (headerSize > static_cast<std::uint64_t>(size)) {
+        throw error::InvalidInputFile();
+    }
+    bytes.resize(headerSize);
+    const auto restSize = ReadChunk(std::span<std::uint8_t>(bytes).subspan(Header::FIXED_SIZE));
+
+    // Check if the file is long enough.
+    if (restSize != headerSize - Header::FIXED_SIZE) {
+        throw error::InvalidInputFile();
+    }
+
+    // Parse the header.
+    return Header::Parse(bytes);
 }
 
-void fc::File::WriteKey(const fc::Key& key) {
-    // Get a copy of the key bytes.
-    const auto bytes = key.GetBytes();
+void fc::File::Reserve(const std::uint64_t totalSize) {
+    // Check if the rest of the file fits the file system (before any data is processed).
+    const auto written = static_cast<std::uint64_t>(size);
+    if (totalSize <= written) {
+        return;
+    }
 
-    // Write these bytes to the file.
-    stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(Key::SIZE));
+    // A device has a fixed size (nothing to allocate, the holes of a sparse file are zeroed there).
+    if (isDevice) {
+        if (std::max(totalSize, extents.GetSize()) > deviceSize) {
+            throw error::NoFreeSpace();
+        }
+        return;
+    }
+    CheckFreeSpace(GetDataPath(), totalSize - written);
+
+    // The holes of a sparse file are not allocated.
+    if (IsSparse()) {
+        return;
+    }
+
+    // The mapped backend allocates the final size itself (its pages must have blocks before they are written).
+    if (mapping) {
+        mapping->Reserve(totalSize);
+        return;
+    }
+
+    // Allocate the file at once (no allocation while writing, less fragmentation and metadata updates).
+    Preallocate(GetDataPath(), totalSize);
+}
+
+void fc::File::SetExtents(const fc::ExtentMap& newExtents) {
+    // Start from the first extent.
+    extents = newExtents;
+    extentIndex = 0;
+    position = 0;
+}
+
+void fc::File::WriteBlock(const fc::Block& block, const std::streamsize bytesToWrite) {
+    // Write block bytes to the file.
+    WriteChunk(std::span<const std::uint8_t>(block.GetData(), static_cast<std::size_t>(bytesToWrite)));
+}
+
+void fc::File::WriteChunk(std::span<const std::uint8_t> chunk) {
+    // Check if the file is sparse.
+    if (!IsSparse()) {
+        backend->Write(chunk);
+    } else {
+        // Write the data extents only (the holes are skipped).
+        for (std::size_t done = 0; done < chunk.size();) {
+            // Check if the data fits the extents.
+            if (extentIndex == extents.GetExtents().size()) {
+                throw error::InvalidInputFile();
+            }
+            const auto count = SeekExtent(chunk.size() - done);
+            backend->Write(chunk.subspan(done, count));
+            AdvanceExtent(count);
+            done += count;
+        }
+    }
 
     // Update file size.
-    size += static_cast<std::streamsize>(Key::SIZE);
+    size += static_cast<std::streamsize>(chunk.size());
+}
+
+void fc::File::WriteHeader(const fc::Header& header) {
+    // Keep the detached header until all data is written (an aborted task leaves the old header file as it is).
+    if (IsHeaderDetached()) {
+        detachedHeader = header.Serialize();
+        return;
+    }
+
+    // Write header bytes to the file.
+    WriteChunk(header.Serialize());
+}
+
+void fc::File::AdvanceExtent(const std::size_t count) noexcept {
+    // Move to the next extent at the end of this one.
+    position += count;
+    const auto& extent = extents.GetExtents()[extentIndex];
+    if (position == extent.offset + extent.size) {
+        extentIndex++;
+    }
+}
+
+std::size_t fc::File::SeekExtent(const std::size_t count) {
+    // Skip the hole before the extent.
+    const auto& extent = extents.GetExtents()[extentIndex];
+    if (position < extent.offset) {
+        backend->Skip(extent.offset - position);
+        position = extent.offset;
+    }
+
+    // Bytes of the extent which fit.
+    return static_cast<std::size_t>(std::min<std::uint64_t>(count, extent.offset + extent.size - position));
 }
@@ -21,21 +21,53 @@
 #define FISHCODE_FILE_HPP
 
 #include <filesystem>
-#include <fstream>
 #include <ios>
+#include <memory>
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "anonymous.hpp"
+#include "backend.hpp"
 #include "block.hpp"
-#include "key.hpp"
+#include "descriptor.hpp"
+#include "header.hpp"
+#include "mapping.hpp"
+#include "sparse.hpp"
 
 namespace fc {
     enum class FileType {
         FT_INPUT,
-        FT_OUTPUT
+        FT_OUTPUT,
+        FT_UPDATE // Existing file read and written in place (DescriptorFile only).
+    };
+
+    enum class FileBackend {
+        FB_STREAM,
+        FB_MMAP,
+        FB_URING,
+        FB_DIRECT,
+        FB_FADVISE
     };
 
     class File {
     public:
+        static constexpr const std::size_t MIN_CHUNK_SIZE = 1 << 20;
+        static constexpr const std::size_t DEFAULT_CHUNK_SIZE = 4 << 20;
+        static constexpr const std::size_t MAX_CHUNK_SIZE = 16 << 20;
+        static constexpr const std::uint64_t MIN_CACHE_WINDOW = 1 << 20;
+        static constexpr const std::uint64_t DEFAULT_CACHE_WINDOW = 64 << 20;
+        static constexpr const std::uint64_t MAX_CACHE_WINDOW = 1 << 30;
+
         File();
-        File(const std::filesystem::path& newFSPath, const FileType type);
+        // Block devices are always accessed with direct I/O. With a detached header ('newHeaderPath' is not empty)
+        // the header is read from that file or written to it by Flush, the file holds only the data.
+        File(
+            const std::filesystem::path& newFSPath,
+            const FileType type,
+            const FileBackend newBackend = GetBackendSetting(),
+            const std::filesystem::path& newHeaderPath = GetHeaderSetting()
+        );
         File(const File& anotherFile) = delete;
         File(File&& anotherFile) noexcept = default;
 
@@ -44,24 +76,119 @@ namespace fc {
         File& operator=(const File& anotherFile) = delete;
         File& operator=(File&& anotherFile) noexcept = default;
 
+        // Backend from the FISHCODE_IO environment variable ("stream", "mmap", "uring", "direct" or "fadvise"), or
+        // FB_STREAM.
+        static FileBackend GetBackendSetting() noexcept;
+
+        // Page cache window of the FB_FADVISE backend from the FISHCODE_CACHE_WINDOW environment variable (in MiB),
+        // DEFAULT_CACHE_WINDOW otherwise.
+        static std::uint64_t GetCacheWindowSetting() noexcept;
+
+        // Chunk size from the FISHCODE_CHUNK_SIZE environment variable (in MiB), DEFAULT_CHUNK_SIZE otherwise.
+        static std::size_t GetChunkSizeSetting() noexcept;
+
+        // Data extents of the file (an empty map for a file without holes or a device, see ExtentMap::Find).
+        ExtentMap FindExtents() const;
+
+        // File holding the header of 'fsPath' (the detached header or the file itself).
+        static std::filesystem::path GetHeaderFilePath(const std::filesystem::path& fsPath);
+
+        // Detached header from the FISHCODE_HEADER environment variable, or an empty path.
+        static std::filesystem::path GetHeaderSetting();
+
+        // Skipping of the holes from the FISHCODE_SPARSE environment variable ("1"), off by default: the extents are
+        // stored in the header unencrypted, so they disclose the layout of the holes in the plain file.
+        static bool GetSparseSetting() noexcept;
+
         inline std::streamsize GetSize() const noexcept {
             return size;
         }
 
+        // Descriptor of a file processed asynchronously (FB_URING backend).
+        inline DescriptorFile& GetDescriptorFile() noexcept {
+            return *descriptor;
+        }
+
+        inline bool IsAsync() const noexcept {
+            return isAsync;
+        }
+
+        inline bool IsHeaderDetached() const noexcept {
+            return !headerPath.empty();
+        }
+
+        inline bool IsMapped() const noexcept {
+            return mapping != nullptr;
+        }
+
+        inline bool IsSparse() const noexcept {
+            return extents.IsSparse();
+        }
+
+        // Writes the buffered bytes of the output file (the direct backend keeps the last partial sector), recreates
+        // the holes of a sparse file and writes the detached header.
+        void Flush();
+
+        // Gives the output file its name (it has no name until the task is completed, see AnonymousFile).
+        void Link();
+
+        // Next bytes of the mapped output file, the data is read or transformed there (see MappedFile).
+        std::span<std::uint8_t> MapWriteChunk(const std::size_t count);
+
         Block ReadBlock(const std::streamsize bytesToRead);
-        Key ReadKey();
+
+        // Reads up to 'chunk.size()' bytes (less only at the end of the file), returns the number of bytes read.
+        std::size_t ReadChunk(std::span<std::uint8_t> chunk);
+        Header ReadHeader();
 
         inline void Remove() {
-            // Remove this file using filesystem path.
-            std::filesystem::remove(fsPath);
+            // Remove this file using filesystem path (a device is kept, an unnamed file is freed by the file system).
+            if (!isDevice && !anonymous) {
+                std::filesystem::remove(fsPath);
+            }
         }
 
-        void WriteBlock(const Block& block);
-        void WriteKey(const Key& key);
+        // Checks free space (or the size of the device) for the rest of the output file and preallocates it
+        // (throws error::NoFreeSpace).
+        void Reserve(const std::uint64_t totalSize);
+
+        // Chunks of a sparse file (its plain data, no header) are read from or written to the data extents only, the
+        // holes are skipped (and recreated by Flush).
+        void SetExtents(const ExtentMap& newExtents);
+
+        void WriteBlock(const Block& block, const std::streamsize bytesToWrite);
+        void WriteChunk(std::span<const std::uint8_t> chunk);
+        void WriteHeader(const Header& header);
     private:
         std::filesystem::path fsPath;
         std::streamsize size;
-        std::fstream stream;
+        std::unique_ptr<Backend> backend;
+        std::unique_ptr<AnonymousFile> anonymous;
+
+        // Backend specific access (null for the other backends).
+        MappedFile* mapping = nullptr;
+        DescriptorFile* descriptor = nullptr;
+        std::filesystem::path headerPath;
+        std::vector<std::uint8_t> detachedHeader;
+        ExtentMap extents;
+        std::size_t extentIndex = 0;
+        std::uint64_t position = 0;
+        std::uint64_t deviceSize = 0;
+        bool isAsync = false;
+        bool isDevice = false;
+        bool isOutput = false;
+
+        // Path opening the data of the file (see AnonymousFile).
+        inline const std::filesystem::path& GetDataPath() const noexcept {
+            return anonymous ? anonymous->GetPath() : fsPath;
+        }
+
+        // Moves to the current extent, returns how many of 'count' bytes fit it.
+        std::size_t SeekExtent(const std::size_t count);
+
+        // Moves the position past 'count' bytes of the current extent.
+        void AdvanceExtent(const std::size_t count) noexcept;
+
     };
 }
 
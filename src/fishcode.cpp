@@ -25,14 +25,29 @@
 #include <exception>
 #include <iostream>
 #include <wx/msgdlg.h>
+#include "command.hpp"
 #include "fishcode.hpp"
 #include "frame.hpp"
+#include "kernel.hpp"
 #include "strings.hpp"
 
-// This defines the equivalent of main() for the current platform.
-wxIMPLEMENT_APP(fc::FishCode);
+// This defines the application object (main() is defined below).
+wxIMPLEMENT_APP_NO_MAIN(fc::FishCode);
+
+int main(int argc, char* argv[]) {
+    // Run headless operations without the GUI (and without a display).
+    if (fc::IsCommand(argc, argv)) {
+        return fc::RunCommand(argc, argv);
+    }
+
+    // Start the GUI.
+    return wxEntry(argc, argv);
+}
 
 bool fc::FishCode::OnInit() try {
+    // Report the cipher kernel chosen for this CPU.
+    std::clog << STR_INFO0 << kernel::GetActive().name << std::endl;
+
     // Create the main window (frame).
     auto frame = new Frame();
 
@@ -29,17 +29,25 @@
 #include <utility>
 #include <cstdlib>
 #include <wx/aboutdlg.h>
+#include <wx/choicdlg.h>
 #include <wx/event.h>
 #include <wx/filedlg.h>
 #include <wx/frame.h>
 #include <wx/menu.h>
 #include <wx/msgdlg.h>
 #include <wx/sizer.h>
+#include <wx/string.h>
+#include <wx/textdlg.h>
 #include <wx/timer.h>
 #include "error.hpp"
 #include "events.hpp"
+#include "file.hpp"
 #include "frame.hpp"
+#include "inplace.hpp"
+#include "kernel.hpp"
+#include "password.hpp"
 #include "progress.hpp"
+#include "rewrap.hpp"
 #include "strings.hpp"
 #include "task.hpp"
 
@@ -51,6 +59,10 @@ fc::Frame::Frame()
     menuMore->Append(wxID_ABOUT, STR_NAME2, STR_PROMPT0);
     menuMore->Append(wxID_HELP, STR_NAME3, STR_PROMPT1);
     menuBar->Append(menuMore, STR_NAME1);
+    auto menuCipher = new wxMenu();
+    menuCipher->AppendRadioItem(events::ID_SUITE_FISHCODE, STR_NAME5, STR_PROMPT2);
+    menuCipher->AppendRadioItem(events::ID_SUITE_AES, STR_NAME6, STR_PROMPT3);
+    menuBar->Append(menuCipher, STR_NAME4);
 
     // Connect menu bar to the frame.
     SetMenuBar(menuBar);
@@ -58,6 +70,11 @@ fc::Frame::Frame()
     // Configure menu bar event handlers.
     Bind(wxEVT_MENU, &fc::Frame::OnAbout, this, wxID_ABOUT);
     Bind(wxEVT_MENU, &fc::Frame::OnHelp, this, wxID_HELP);
+    Bind(wxEVT_MENU, &fc::Frame::OnSuite, this, events::ID_SUITE_FISHCODE);
+    Bind(wxEVT_MENU, &fc::Frame::OnSuite, this, events::ID_SUITE_AES);
+
+    // Use the original algorithm by default.
+    suite = CipherSuite::CS_FISHCODE;
 
     // Create and set new status bar for the frame.
     SetStatusBar(CreateStatusBar());
@@ -84,7 +101,7 @@ fc::Frame::Frame()
         new wxFlexGridSizer(1, 3, gridLayout),
         new wxFlexGridSizer(1, 3, gridLayout),
         new wxFlexGridSizer(1, 2, gridLayout),
-        new wxFlexGridSizer(1, 2, gridLayout)
+        new wxFlexGridSizer(1, 4, gridLayout)
     };
     gridSizers[0]->AddGrowableCol(1);
     gridSizers[0]->AddGrowableCol(2);
@@ -93,6 +110,8 @@ fc::Frame::Frame()
     gridSizers[2]->AddGrowableCol(1);
     gridSizers[3]->AddGrowableCol(0);
     gridSizers[3]->AddGrowableCol(1);
+    gridSizers[3]->AddGrowableCol(2);
+    gridSizers[3]->AddGrowableCol(3);
 
     // Create and configure input fields.
     fields[0] = new Field(this);
@@ -118,6 +137,8 @@ fc::Frame::Frame()
     buttons[2] = new Button(this, events::ID_ENCRYPT, STR_LABEL5);
     buttons[3] = new Button(this, events::ID_DECRYPT, STR_LABEL6);
     buttons[4] = new Button(this, events::ID_CANCEL, STR_LABEL7);
+    buttons[5] = new Button(this, events::ID_REKEY, STR_LABEL8);
+    buttons[6] = new Button(this, events::ID_PASSWORD, STR_LABEL9);
 
     // Disable "Cancel" button for now.
     buttons[4]->Disable();
@@ -143,6 +164,8 @@ fc::Frame::Frame()
     // Configure main control buttons.
     gridSizers[3]->Add(buttons[2], gridSizerFlags);
     gridSizers[3]->Add(buttons[3], gridSizerFlags);
+    gridSizers[3]->Add(buttons[5], gridSizerFlags);
+    gridSizers[3]->Add(buttons[6], gridSizerFlags);
 
     // Add main control buttons to the frame (using sizer).
     boxSizer->Add(gridSizers[3], gridSizerFlags);
@@ -156,6 +179,8 @@ fc::Frame::Frame()
     buttons[2]->Bind(wxEVT_BUTTON, &fc::Frame::OnEncrypt, this, events::ID_ENCRYPT);
     buttons[3]->Bind(wxEVT_BUTTON, &fc::Frame::OnDecrypt, this, events::ID_DECRYPT);
     buttons[4]->Bind(wxEVT_BUTTON, &fc::Frame::OnCancel, this, events::ID_CANCEL);
+    buttons[5]->Bind(wxEVT_BUTTON, &fc::Frame::OnRekey, this, events::ID_REKEY);
+    buttons[6]->Bind(wxEVT_BUTTON, &fc::Frame::OnPassword, this, events::ID_PASSWORD);
 
     // Connect main window (frame) with its sizer.
     SetSizerAndFit(boxSizer);
@@ -182,7 +207,7 @@ void fc::Frame::OnAbout(wxCommandEvent& event) {
     wxAboutDialogInfo aboutDialogInfo;
     aboutDialogInfo.SetName(STR_NAME0);
     aboutDialogInfo.SetVersion(STR_VERSION);
-    aboutDialogInfo.SetDescription(STR_DESCRYPTION);
+    aboutDialogInfo.SetDescription(wxString(STR_DESCRYPTION) + "\n\n" + STR_INFO0 + kernel::GetActive().name);
     aboutDialogInfo.SetCopyright(STR_COPYRIGHT);
     aboutDialogInfo.AddDeveloper(STR_DEVELOPER);
 
@@ -265,26 +290,41 @@ void fc::Frame::OnDecrypt(wxCommandEvent& event) try {
     // Get user password (as string).
     const auto password = GetPasswordValue().utf8_string();
 
+    // Both pathes point to the same file in the in-place mode (its interrupted task is checked by the task itself).
+    const auto isInPlace = IsSameFile(ifPath, ofPath);
+    const auto isResumed = isInPlace && HasJournal(ifPath);
+
     // Check user data.
-    CheckFileIO(ifPath, ofPath);
-    CheckInputFile(ifPath, true);
+    CheckFileIO(ifPath, ofPath, true);
+    if (!isResumed) {
+        CheckInputFile(ifPath, true);
+    }
     CheckOutputFile(ofPath);
     CheckPassword(password);
+    if (!isResumed) {
+        CheckInputPassword(ifPath, password);
+    }
 
     // Allocate memory for the task data.
     auto data = std::make_unique<TaskData>();
 
-    // Open the input file.
-    data->SetInputFile(ifPath);
+    // Check if the file is decrypted in place.
+    if (isInPlace) {
+        // Store the path of the file.
+        data->SetInPlaceFile(ifPath);
+    } else {
+        // Open the input file.
+        data->SetInputFile(ifPath);
 
-    // Create an output file.
-    data->SetOutputFile(ofPath);
+        // Create an output file.
+        data->SetOutputFile(ofPath);
+    }
 
     // Store user password.
     data->SetPassword(password);
 
     // Create new thread for the decryption task.
-    taskThread = std::make_unique<std::thread>(TaskDecrypt, this, std::move(data));
+    taskThread = std::make_unique<std::thread>(isInPlace ? TaskDecryptInPlace : TaskDecrypt, this, std::move(data));
 } catch (const std::exception& ex) {
     // Send a message about the task abortion.
     wxPostEvent(buttons[4], wxCommandEvent(wxEVT_BUTTON, events::ID_CANCEL));
@@ -334,26 +374,41 @@ void fc::Frame::OnEncrypt(wxCommandEvent& event) try {
     // Get user password (as string).
     const auto password = GetPasswordValue().utf8_string();
 
+    // Both pathes point to the same file in the in-place mode (its interrupted task is checked by the task itself).
+    const auto isInPlace = IsSameFile(ifPath, ofPath);
+    const auto isResumed = isInPlace && HasJournal(ifPath);
+
     // Check user data.
-    CheckFileIO(ifPath, ofPath);
-    CheckInputFile(ifPath, false);
+    CheckFileIO(ifPath, ofPath, true);
+    if (!isResumed) {
+        CheckInputFile(ifPath, false);
+    }
     CheckOutputFile(ofPath);
     CheckPassword(password);
 
     // Allocate memory for the task data.
     auto data = std::make_unique<TaskData>();
 
-    // Open the input file.
-    data->SetInputFile(ifPath);
+    // Check if the file is encrypted in place.
+    if (isInPlace) {
+        // Store the path of the file.
+        data->SetInPlaceFile(ifPath);
+    } else {
+        // Open the input file.
+        data->SetInputFile(ifPath);
 
-    // Create an output file.
-    data->SetOutputFile(ofPath);
+        // Create an output file.
+        data->SetOutputFile(ofPath);
+    }
 
     // Store user password.
     data->SetPassword(password);
 
+    // Store selected cipher suite.
+    data->SetSuite(suite);
+
     // Create new thread for the encryption task.
-    taskThread = std::make_unique<std::thread>(TaskEncrypt, this, std::move(data));
+    taskThread = std::make_unique<std::thread>(isInPlace ? TaskEncryptInPlace : TaskEncrypt, this, std::move(data));
 } catch (const std::exception& ex) {
     // Send a message about the task abortion.
     wxPostEvent(buttons[4], wxCommandEvent(wxEVT_BUTTON, events::ID_CANCEL));
@@ -367,6 +422,78 @@ void fc::Frame::OnHelp(wxCommandEvent& event) {
     wxMessageBox(STR_DOCUMENTATION, STR_CAPTION0, wxOK | wxCENTRE | wxICON_QUESTION, this);
 }
 
+void fc::Frame::OnPassword(wxCommandEvent& event) try {
+    // Get path to the input file.
+    const auto ifPath = std::filesystem::path(GetIFPathValue().utf8_string());
+
+    // Get current user password (as string).
+    const auto password = GetPasswordValue().utf8_string();
+
+    // Check user data.
+    CheckInputFile(ifPath, true);
+    CheckPassword(password);
+    CheckInputPassword(ifPath, password);
+
+    // Key slots of a detached header are rewritten in its own file.
+    const auto headerPath = File::GetHeaderFilePath(ifPath);
+
+    // Ask for the operation.
+    const wxString operations[] = {STR_NAME7, STR_NAME8, STR_NAME9};
+    const auto operation = wxGetSingleChoiceIndex(STR_PROMPT8, STR_CAPTION5, 3, operations, this);
+
+    // Check if user has cancelled the dialog.
+    if (operation < 0) {
+        return;
+    }
+
+    // Remove the password (no new password is needed).
+    if (operation == 2) {
+        RemovePassword(headerPath, Password(password));
+        SetStatusText(STR_STATUS8);
+        readyTimer->StartOnce(3000);
+        return;
+    }
+
+    // Ask for the new password.
+    const auto newPassword = wxGetPasswordFromUser(STR_PROMPT6, STR_CAPTION5, wxEmptyString, this).utf8_string();
+
+    // Check if user has cancelled the dialog.
+    if (newPassword.empty()) {
+        return;
+    }
+
+    // Ask for the new password again (it cannot be recovered).
+    const auto repeatedPassword = wxGetPasswordFromUser(STR_PROMPT7, STR_CAPTION5, wxEmptyString, this).utf8_string();
+
+    // Check the new password.
+    CheckPassword(newPassword);
+    if (repeatedPassword != newPassword) {
+        throw error::InvalidPassword();
+    }
+
+    // Rewrite the header of the file (no task thread is needed).
+    if (operation == 0) {
+        ChangePassword(headerPath, Password(password), Password(newPassword));
+
+        // The new password is the current one now.
+        fields[2]->ChangeValue(wxString::FromUTF8(newPassword));
+
+        // Set new status in the status bar.
+        SetStatusText(STR_STATUS6);
+    } else {
+        AddPassword(headerPath, Password(password), Password(newPassword));
+
+        // Set new status in the status bar.
+        SetStatusText(STR_STATUS7);
+    }
+
+    // Start timer to the new status.
+    readyTimer->StartOnce(3000);
+} catch (const std::exception& ex) {
+    // Display GUI error message.
+    wxMessageBox(ex.what(), STR_CAPTION4, wxOK | wxCENTRE | wxICON_ERROR, this);
+}
+
 void fc::Frame::OnProgressUpdate(events::UpdateProgress& event) {
     // Set new value in the progress bar.
     progressBar->SetValue(event.GetProgress());
@@ -388,6 +515,52 @@ void fc::Frame::OnReadyTimer(wxTimerEvent& event) {
     DisableProgressBar();
 }
 
+void fc::Frame::OnRekey(wxCommandEvent& event) try {
+    // Set frame to the "processing" mode.
+    DisableButtons();
+    DisableFields();
+    EnableCancelButton();
+    EnableProgressBar();
+
+    // Display new status in the status bar.
+    SetStatusText(STR_STATUS5);
+
+    // Get pathes to input and output files.
+    const auto ifPath = std::filesystem::path(GetIFPathValue().utf8_string());
+    const auto ofPath = std::filesystem::path(GetOFPathValue().utf8_string());
+
+    // Get user password (as string).
+    const auto password = GetPasswordValue().utf8_string();
+
+    // Check user data.
+    CheckFileIO(ifPath, ofPath);
+    CheckInputFile(ifPath, true);
+    CheckOutputFile(ofPath);
+    CheckPassword(password);
+    CheckInputPassword(ifPath, password);
+
+    // Allocate memory for the task data.
+    auto data = std::make_unique<TaskData>();
+
+    // Open the input file.
+    data->SetInputFile(ifPath);
+
+    // Create an output file.
+    data->SetOutputFile(ofPath);
+
+    // Store user password.
+    data->SetPassword(password);
+
+    // Create new thread for the rekeying task.
+    taskThread = std::make_unique<std::thread>(TaskRekey, this, std::move(data));
+} catch (const std::exception& ex) {
+    // Send a message about the task abortion.
+    wxPostEvent(buttons[4], wxCommandEvent(wxEVT_BUTTON, events::ID_CANCEL));
+
+    // Display GUI error message.
+    wxMessageBox(ex.what(), STR_CAPTION4, wxOK | wxCENTRE | wxICON_ERROR, this);
+}
+
 void fc::Frame::OnSet(wxCommandEvent& event) {
     // Open file selector.
     const auto filePath = wxFileSelector(
@@ -407,6 +580,15 @@ void fc::Frame::OnSet(wxCommandEvent& event) {
     }
 }
 
+void fc::Frame::OnSuite(wxCommandEvent& event) {
+    // Select cipher suite for the next encryption.
+    if (event.GetId() == events::ID_SUITE_AES) {
+        suite = CipherSuite::CS_AES128_CTR;
+    } else {
+        suite = CipherSuite::CS_FISHCODE;
+    }
+}
+
 void fc::Frame::OnTaskException(events::TaskException& event) {
     // Display GUI error message.
     wxMessageBox(event.What(), STR_CAPTION4, wxOK | wxCENTRE | wxICON_ERROR, this);
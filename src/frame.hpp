@@ -34,6 +34,7 @@
 #include <wx/string.h>
 #include <wx/timer.h>
 #include "button.hpp"
+#include "cipher.hpp"
 #include "events.hpp"
 #include "field.hpp"
 #include "label.hpp"
@@ -60,17 +61,21 @@ namespace fc {
         void OnDoneUpdate(events::UpdateDone& event);
         void OnEncrypt(wxCommandEvent& event);
         void OnHelp(wxCommandEvent& event);
+        void OnPassword(wxCommandEvent& event);
         void OnProgressUpdate(events::UpdateProgress& event);
         void OnReadyTimer(wxTimerEvent& event);
+        void OnRekey(wxCommandEvent& event);
         void OnTaskException(events::TaskException& event);
         void OnSet(wxCommandEvent& event);
+        void OnSuite(wxCommandEvent& event);
     private:
         std::unique_ptr<std::thread> taskThread;
-        std::array<Button*, 5> buttons;
+        std::array<Button*, 7> buttons;
         std::array<Field*, 3> fields;
         std::array<Label*, 3> labels;
         std::unique_ptr<wxTimer> readyTimer;
         ProgressBar* progressBar;
+        CipherSuite suite;
 
         inline wxString GetIFPathValue() const noexcept {
             return fields[0]->GetValue();
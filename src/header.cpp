@@ -0,0 +1,416 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "aes.hpp"
+#include "block.hpp"
+#include "cipher.hpp"
+#include "error.hpp"
+#include "header.hpp"
+#include "kdf.hpp"
+#include "key.hpp"
+#include "password.hpp"
+
+namespace {
+    constexpr const std::size_t VERSION_OFFSET = 8;
+    constexpr const std::size_t SUITE_OFFSET = 9;
+    constexpr const std::size_t FLAGS_OFFSET = 10;
+    constexpr const std::size_t SLOTS_OFFSET = 11;
+    constexpr const std::size_t EXTENTS_OFFSET = 12;
+
+    // Size of the file and the offset and size of every extent.
+    constexpr const std::size_t SIZE_FIELD = 8;
+    constexpr const std::size_t EXTENT_SIZE = 16;
+
+    // Differs from every AES-CTR counter block (its first 8 bytes are not zero).
+    constexpr const std::array<std::uint8_t, fc::Block::SIZE> CHECK_BLOCK = {
+        'F', 'I', 'S', 'H', 'C', 'O', 'D', 'E', 'K', 'E', 'Y', 'C', 'H', 'E', 'C', 'K'
+    };
+
+    void StoreLE(std::uint8_t* bytes, const std::uint64_t value, const std::size_t size) noexcept {
+        // Little-endian order.
+        for (std::size_t index = 0; index < size; index++) {
+            bytes[index] = static_cast<std::uint8_t>(value >> (index * 8));
+        }
+    }
+
+    std::uint64_t LoadLE(const std::uint8_t* bytes, const std::size_t size) noexcept {
+        // Little-endian order.
+        std::uint64_t value = 0;
+        for (std::size_t index = 0; index < size; index++) {
+            value |= static_cast<std::uint64_t>(bytes[index]) << (index * 8);
+        }
+        return value;
+    }
+
+    bool HasMagic(std::span<const std::uint8_t> head) noexcept {
+        // Compare the beginning of the header with the magic.
+        return head.size() >= fc::Header::MAGIC.size()
+            && std::equal(fc::Header::MAGIC.begin(), fc::Header::MAGIC.end(), head.begin());
+    }
+
+    // Offset of the first key slot and size of one slot.
+    inline std::size_t GetSlotsOffset(const bool hasDerivedKeys) noexcept {
+        return fc::Header::FIXED_SIZE + (hasDerivedKeys ? fc::Header::KDF_SIZE : 0);
+    }
+
+    inline std::size_t GetSlotSize(const bool hasDerivedKeys) noexcept {
+        return hasDerivedKeys ? fc::Header::KDF_SLOT_SIZE : fc::Key::SIZE;
+    }
+
+    fc::Key LoadKey(const std::uint8_t* bytes) noexcept {
+        std::array<std::uint8_t, fc::Key::SIZE> keyBytes;
+        std::copy_n(bytes, fc::Key::SIZE, keyBytes.begin());
+        return fc::Key(keyBytes);
+    }
+
+    // The key derived from the password is unique per slot (random salt), so one block of its key stream
+    // encrypts the master key.
+    void CryptKey(fc::Key& key, const fc::Password& password, const fc::Key& salt, const std::uint32_t iterations) {
+        const fc::Aes aes(fc::DeriveKey(password, salt, iterations));
+        aes.Crypt(std::span<std::uint8_t>(key.GetData(), fc::Key::SIZE), 0);
+    }
+}
+
+fc::Header::Header()
+: wrappedKeys(1), salts(1), checkValue() {
+    // Use the original format by default.
+    suite = CipherSuite::CS_FISHCODE;
+    iterations = 0;
+    hasCheckValue = false;
+    hasDerivedKeys = false;
+    legacy = true;
+}
+
+fc::Header::Header(const fc::CipherSuite newSuite, const fc::Key& newWrappedKey)
+: suite(newSuite), wrappedKeys(1, newWrappedKey), salts(1), checkValue() {
+    // FishCode suite without the check value keeps the original format.
+    iterations = 0;
+    hasCheckValue = false;
+    hasDerivedKeys = false;
+    legacy = suite == CipherSuite::CS_FISHCODE;
+}
+
+fc::Header::Header(
+    const fc::CipherSuite newSuite,
+    const fc::Key& key,
+    const fc::Password& password,
+    const std::size_t slots,
+    const std::uint32_t newIterations
+)
+: suite(newSuite), wrappedKeys(std::clamp<std::size_t>(slots, 1, MAX_SLOTS)),
+  salts(std::clamp<std::size_t>(slots, 1, MAX_SLOTS)), checkValue(ComputeCheckValue(key)),
+  iterations(std::clamp<std::uint32_t>(newIterations, 1, MAX_KDF_ITERATIONS)) {
+    // The check value and the derived keys need the tagged format.
+    hasCheckValue = true;
+    hasDerivedKeys = true;
+    legacy = false;
+
+    // The first slot is used, the others are free.
+    WrapKey(0, key, password);
+}
+
+std::size_t fc::Header::GetSerializedSize(std::span<const std::uint8_t> head) {
+    // Check if there is enough data.
+    if (head.size() < FIXED_SIZE) {
+        throw error::InvalidInputFile();
+    }
+
+    // Legacy header is the wrapped key only.
+    if (!HasMagic(head)) {
+        return Key::SIZE;
+    }
+
+    // Check the version and flags (the derived keys are found by the check value).
+    const auto flags = head[FLAGS_OFFSET];
+    if (head[VERSION_OFFSET] != VERSION || (flags & ~(FLAG_CHECK_VALUE | FLAG_EXTENTS | FLAG_KDF)) != 0) {
+        throw error::InvalidInputFile();
+    }
+    const auto hasDerivedKeys = (flags & FLAG_KDF) != 0;
+    if (hasDerivedKeys && (flags & FLAG_CHECK_VALUE) == 0) {
+        throw error::InvalidInputFile();
+    }
+
+    // Check the number of key slots (several slots need the check value).
+    const std::size_t slots = head[SLOTS_OFFSET];
+    if (slots == 0 || (slots > 1 && (flags & FLAG_CHECK_VALUE) == 0)) {
+        throw error::InvalidInputFile();
+    }
+
+    // Check the number of extents.
+    const auto extents = LoadLE(head.data() + EXTENTS_OFFSET, 4);
+    if ((flags & FLAG_EXTENTS) == 0 ? extents != 0 : extents > ExtentMap::MAX_EXTENTS) {
+        throw error::InvalidInputFile();
+    }
+
+    // Fixed part, the key slots, the check value and the extents (if any).
+    const auto checkSize = (flags & FLAG_CHECK_VALUE) != 0 ? CHECK_SIZE : 0;
+    const auto extentsSize = (flags & FLAG_EXTENTS) != 0 ? SIZE_FIELD + extents * EXTENT_SIZE : 0;
+    return GetSlotsOffset(hasDerivedKeys) + slots * GetSlotSize(hasDerivedKeys) + checkSize + extentsSize;
+}
+
+fc::Header fc::Header::Parse(std::span<const std::uint8_t> bytes) {
+    // Check the size of the header.
+    const auto size = GetSerializedSize(bytes);
+    if (bytes.size() < size) {
+        throw error::InvalidInputFile();
+    }
+
+    // Legacy header: FishCode suite and the wrapped key.
+    if (!HasMagic(bytes)) {
+        return Header(CipherSuite::CS_FISHCODE, LoadKey(bytes.data()));
+    }
+
+    // Check the cipher suite.
+    if (!Cipher::IsSuite(bytes[SUITE_OFFSET])) {
+        throw error::InvalidInputFile();
+    }
+
+    // Read the fixed part.
+    Header header;
+    header.suite = static_cast<CipherSuite>(bytes[SUITE_OFFSET]);
+    header.hasCheckValue = (bytes[FLAGS_OFFSET] & FLAG_CHECK_VALUE) != 0;
+    header.hasDerivedKeys = (bytes[FLAGS_OFFSET] & FLAG_KDF) != 0;
+    header.legacy = false;
+
+    // Read the iteration count of the derived keys.
+    if (header.hasDerivedKeys) {
+        header.iterations = static_cast<std::uint32_t>(LoadLE(bytes.data() + FIXED_SIZE, KDF_SIZE));
+        if (header.iterations == 0 || header.iterations > MAX_KDF_ITERATIONS) {
+            throw error::InvalidInputFile();
+        }
+    }
+
+    // Read the key slots (salt and wrapped key, or the wrapped key only).
+    const auto slotsOffset = GetSlotsOffset(header.hasDerivedKeys);
+    const auto slotSize = GetSlotSize(header.hasDerivedKeys);
+    header.wrappedKeys.resize(bytes[SLOTS_OFFSET]);
+    header.salts.resize(bytes[SLOTS_OFFSET]);
+    for (std::size_t slot = 0; slot < header.wrappedKeys.size(); slot++) {
+        const auto slotBytes = bytes.data() + slotsOffset + slot * slotSize;
+        if (header.hasDerivedKeys) {
+            header.salts[slot] = LoadKey(slotBytes);
+        }
+        header.wrappedKeys[slot] = LoadKey(slotBytes + slotSize - Key::SIZE);
+    }
+
+    // Read the check value.
+    const auto checkOffset = slotsOffset + header.wrappedKeys.size() * slotSize;
+    if (header.hasCheckValue) {
+        std::copy_n(bytes.begin() + checkOffset, CHECK_SIZE, header.checkValue.begin());
+    }
+
+    // Read the extents of a sparse file.
+    if ((bytes[FLAGS_OFFSET] & FLAG_EXTENTS) != 0) {
+        const auto offset = checkOffset + (header.hasCheckValue ? CHECK_SIZE : 0);
+        std::vector<Extent> extents(LoadLE(bytes.data() + EXTENTS_OFFSET, 4));
+        for (std::size_t index = 0; index < extents.size(); index++) {
+            const auto extentBytes = bytes.data() + offset + SIZE_FIELD + index * EXTENT_SIZE;
+            extents[index] = {LoadLE(extentBytes, 8), LoadLE(extentBytes + 8, 8)};
+        }
+
+        // The size of the file is not 0 (an empty map means a file without holes).
+        const auto size = LoadLE(bytes.data() + offset, SIZE_FIELD);
+        if (size == 0) {
+            throw error::InvalidInputFile();
+        }
+        header.extents = ExtentMap(std::move(extents), size);
+    }
+
+    // Return the header.
+    return header;
+}
+
+fc::Header::CheckValue fc::Header::ComputeCheckValue(const fc::Key& key) {
+    // Encrypt the constant block with the master key (AES is one-way with respect to the key).
+    const auto block = Aes(key).EncryptBlock(Block(CHECK_BLOCK));
+
+    // Use the beginning of the result (a wrong password passes with probability 2^-64).
+    CheckValue checkValue;
+    std::copy_n(block.GetBytes().begin(), CHECK_SIZE, checkValue.begin());
+    return checkValue;
+}
+
+std::size_t fc::Header::FindSlot(const fc::Password& password) const {
+    // Without the check value there is only one slot and any password is accepted.
+    if (!hasCheckValue) {
+        return 0;
+    }
+
+    // Try every used slot.
+    for (std::size_t slot = 0; slot < wrappedKeys.size(); slot++) {
+        Key key;
+        if (TryUnwrapKey(slot, password, key)) {
+            return slot;
+        }
+    }
+
+    // No slot for this password.
+    throw error::InvalidPassword();
+}
+
+std::size_t fc::Header::GetSize() const noexcept {
+    // Legacy header is the wrapped key only.
+    if (IsLegacy()) {
+        return Key::SIZE;
+    }
+
+    // Fixed part, the key slots, the check value and the extents (if any).
+    const auto slotsSize = wrappedKeys.size() * GetSlotSize(hasDerivedKeys);
+    const auto checkSize = hasCheckValue ? CHECK_SIZE : 0;
+    const auto extentsSize = extents.IsSparse() ? SIZE_FIELD + extents.GetExtents().size() * EXTENT_SIZE : 0;
+    return GetSlotsOffset(hasDerivedKeys) + slotsSize + checkSize + extentsSize;
+}
+
+std::size_t fc::Header::GetUsedSlots() const noexcept {
+    // Count slots which are not free.
+    std::size_t used = 0;
+    for (std::size_t slot = 0; slot < wrappedKeys.size(); slot++) {
+        if (!IsFreeSlot(slot)) {
+            used++;
+        }
+    }
+    return used;
+}
+
+std::vector<std::uint8_t> fc::Header::Serialize() const {
+    // Create storage for the header.
+    std::vector<std::uint8_t> bytes(GetSize(), 0);
+
+    // Check if it is legacy header.
+    if (IsLegacy()) {
+        std::copy(wrappedKeys[0].GetBytes().begin(), wrappedKeys[0].GetBytes().end(), bytes.begin());
+        return bytes;
+    }
+
+    // Store the fixed part.
+    std::copy(MAGIC.begin(), MAGIC.end(), bytes.begin());
+    bytes[VERSION_OFFSET] = VERSION;
+    bytes[SUITE_OFFSET] = static_cast<std::uint8_t>(suite);
+    bytes[FLAGS_OFFSET] = (hasCheckValue ? FLAG_CHECK_VALUE : 0) | (extents.IsSparse() ? FLAG_EXTENTS : 0)
+        | (hasDerivedKeys ? FLAG_KDF : 0);
+    bytes[SLOTS_OFFSET] = static_cast<std::uint8_t>(wrappedKeys.size());
+    StoreLE(bytes.data() + EXTENTS_OFFSET, extents.GetExtents().size(), 4);
+
+    // Store the iteration count of the derived keys.
+    if (hasDerivedKeys) {
+        StoreLE(bytes.data() + FIXED_SIZE, iterations, KDF_SIZE);
+    }
+
+    // Store the key slots (salt and wrapped key, or the wrapped key only).
+    const auto slotsOffset = GetSlotsOffset(hasDerivedKeys);
+    const auto slotSize = GetSlotSize(hasDerivedKeys);
+    for (std::size_t slot = 0; slot < wrappedKeys.size(); slot++) {
+        const auto slotBytes = bytes.begin() + slotsOffset + slot * slotSize;
+        if (hasDerivedKeys) {
+            std::copy(salts[slot].GetBytes().begin(), salts[slot].GetBytes().end(), slotBytes);
+        }
+        const auto& keyBytes = wrappedKeys[slot].GetBytes();
+        std::copy(keyBytes.begin(), keyBytes.end(), slotBytes + slotSize - Key::SIZE);
+    }
+
+    // Store the check value.
+    const auto checkOffset = slotsOffset + wrappedKeys.size() * slotSize;
+    if (hasCheckValue) {
+        std::copy(checkValue.begin(), checkValue.end(), bytes.begin() + checkOffset);
+    }
+
+    // Store the extents of a sparse file.
+    if (extents.IsSparse()) {
+        const auto offset = checkOffset + (hasCheckValue ? CHECK_SIZE : 0);
+        StoreLE(bytes.data() + offset, extents.GetSize(), SIZE_FIELD);
+        for (std::size_t index = 0; index < extents.GetExtents().size(); index++) {
+            const auto extentBytes = bytes.data() + offset + SIZE_FIELD + index * EXTENT_SIZE;
+            StoreLE(extentBytes, extents.GetExtents()[index].offset, 8);
+            StoreLE(extentBytes + 8, extents.GetExtents()[index].size, 8);
+        }
+    }
+
+    // Return the header.
+    return bytes;
+}
+
+fc::Key fc::Header::UnwrapKey(const fc::Password& password) const {
+    // Without the check value there is only one slot and any password is accepted.
+    if (!hasCheckValue) {
+        return UnwrapKey(0, password);
+    }
+
+    // Find the slot of the password (the key is checked by the check value).
+    for (std::size_t slot = 0; slot < wrappedKeys.size(); slot++) {
+        Key key;
+        if (TryUnwrapKey(slot, password, key)) {
+            return key;
+        }
+    }
+
+    // No slot for this password.
+    throw error::InvalidPassword();
+}
+
+fc::Key fc::Header::UnwrapKey(const std::size_t slot, const fc::Password& password) const {
+    // Decrypt the key.
+    auto key = wrappedKeys[slot];
+    if (hasDerivedKeys) {
+        CryptKey(key, password, salts[slot], iterations);
+    } else {
+        key.Decrypt(password);
+    }
+
+    // Return the master key.
+    return key;
+}
+
+void fc::Header::WrapKey(const std::size_t slot, const fc::Key& key, const fc::Password& password) {
+    // FishCode slots of two passwords reveal the XOR of the passwords.
+    if (!hasDerivedKeys) {
+        for (std::size_t other = 0; other < wrappedKeys.size(); other++) {
+            if (other != slot && !IsFreeSlot(other)) {
+                throw error::LegacyKeySlots();
+            }
+        }
+
+        // Encrypt the key with the password itself.
+        wrappedKeys[slot] = key;
+        wrappedKeys[slot].Encrypt(password);
+        return;
+    }
+
+    // Encrypt the key under the key derived from the password and a new salt.
+    salts[slot] = Key::Generate();
+    wrappedKeys[slot] = key;
+    CryptKey(wrappedKeys[slot], password, salts[slot], iterations);
+}
+
+bool fc::Header::TryUnwrapKey(const std::size_t slot, const fc::Password& password, fc::Key& key) const {
+    // Free slots hold no key.
+    if (IsFreeSlot(slot)) {
+        return false;
+    }
+
+    // Decrypt the key and compare its check value.
+    key = UnwrapKey(slot, password);
+    return ComputeCheckValue(key) == checkValue;
+}
@@ -0,0 +1,160 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_HEADER_HPP
+#define FISHCODE_HEADER_HPP
+
+#include <array>
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "cipher.hpp"
+#include "key.hpp"
+#include "password.hpp"
+#include "sparse.hpp"
+
+namespace fc {
+    /*
+    ** Encrypted file header. The original (legacy) header is just the wrapped key (16 bytes). The tagged header is
+    ** the magic "FISHCODE", version, cipher suite, flags, number of key slots, number of extents (4 bytes) and the key
+    ** slots, followed by the key-check value if FLAG_CHECK_VALUE is set. Every used slot holds the same master key
+    ** wrapped under a different password, a free slot is all zeros (several slots need the check value to find the
+    ** slot of a password). If FLAG_KDF is set, the PBKDF2 iteration count (4 bytes) precedes the slots and every slot
+    ** is a random salt and the master key encrypted with AES-128 under the key derived from the password and the salt
+    ** (32 bytes). Otherwise a slot is the master key encrypted with FishCode under the password itself (16 bytes):
+    ** FishCode is affine, so two such slots reveal the XOR of their passwords, and these headers never get a second
+    ** password. A legacy header starts with the magic only by chance (probability 2^-64).
+    ** If FLAG_EXTENTS is set, the plain file is sparse: the size of the file and its data extents (offset and size,
+    ** 8 bytes each) follow, and only the data of the extents is stored (see ExtentMap). Integers are little-endian.
+    */
+    class Header {
+    public:
+        static constexpr const std::array<std::uint8_t, 8> MAGIC = {'F', 'I', 'S', 'H', 'C', 'O', 'D', 'E'};
+        static constexpr const std::uint8_t VERSION = 2;
+        static constexpr const std::size_t FIXED_SIZE = 16;
+        static constexpr const std::size_t KDF_SIZE = 4;
+        static constexpr const std::size_t KDF_SLOT_SIZE = 2 * Key::SIZE;
+        static constexpr const std::size_t CHECK_SIZE = 8;
+        static constexpr const std::size_t DEFAULT_SLOTS = 4;
+        static constexpr const std::size_t MAX_SLOTS = 255;
+        static constexpr const std::uint32_t KDF_ITERATIONS = 100000;
+        static constexpr const std::uint32_t MAX_KDF_ITERATIONS = 1 << 24;
+        static constexpr const std::uint8_t FLAG_CHECK_VALUE = 0x01;
+        static constexpr const std::uint8_t FLAG_EXTENTS = 0x02;
+        static constexpr const std::uint8_t FLAG_KDF = 0x04;
+
+        using CheckValue = std::array<std::uint8_t, CHECK_SIZE>;
+
+        Header();
+        Header(const CipherSuite newSuite, const Key& newWrappedKey);
+        // Wraps 'key' under 'password' in the first slot (the others are free) and stores its check value.
+        Header(
+            const CipherSuite newSuite,
+            const Key& key,
+            const Password& password,
+            const std::size_t slots = 1,
+            const std::uint32_t newIterations = KDF_ITERATIONS
+        );
+        Header(const Header& otherHeader) = default;
+        Header(Header&& otherHeader) noexcept = default;
+
+        ~Header() noexcept = default;
+
+        Header& operator=(const Header& otherHeader) = default;
+        Header& operator=(Header&& otherHeader) noexcept = default;
+
+        // Full header size, known from its first FIXED_SIZE bytes.
+        static std::size_t GetSerializedSize(std::span<const std::uint8_t> head);
+        static Header Parse(std::span<const std::uint8_t> bytes);
+
+        // Check value of the master key (AES-128 of a constant block, reveals nothing about the key).
+        static CheckValue ComputeCheckValue(const Key& key);
+
+        inline const ExtentMap& GetExtents() const noexcept {
+            return extents;
+        }
+
+        inline std::size_t GetSlots() const noexcept {
+            return wrappedKeys.size();
+        }
+
+        inline CipherSuite GetSuite() const noexcept {
+            return suite;
+        }
+
+        inline bool HasCheckValue() const noexcept {
+            return hasCheckValue;
+        }
+
+        inline bool HasDerivedKeys() const noexcept {
+            return hasDerivedKeys;
+        }
+
+        inline bool IsFreeSlot(const std::size_t slot) const noexcept {
+            return wrappedKeys[slot].GetBytes() == Key().GetBytes() && salts[slot].GetBytes() == Key().GetBytes();
+        }
+
+        inline bool IsLegacy() const noexcept {
+            return legacy;
+        }
+
+        inline void ClearSlot(const std::size_t slot) noexcept {
+            // Mark the slot as free.
+            wrappedKeys[slot] = Key();
+            salts[slot] = Key();
+        }
+
+        inline void SetExtents(const ExtentMap& newExtents) {
+            // Only the tagged header stores the extents (its size grows with them).
+            extents = newExtents;
+        }
+
+        // Throws error::InvalidPassword if no used slot matches the password (the first slot without check value).
+        std::size_t FindSlot(const Password& password) const;
+        std::size_t GetSize() const noexcept;
+        std::size_t GetUsedSlots() const noexcept;
+        std::vector<std::uint8_t> Serialize() const;
+
+        // Decrypts the master key (throws error::InvalidPassword if the check value does not match).
+        Key UnwrapKey(const Password& password) const;
+
+        // Decrypts the master key of the slot (found by FindSlot, the password is not checked again).
+        Key UnwrapKey(const std::size_t slot, const Password& password) const;
+
+        // Encrypts the master key under the password into the slot (the layout of the header is not changed). Headers
+        // without FLAG_KDF keep only one used slot (throws error::LegacyKeySlots).
+        void WrapKey(const std::size_t slot, const Key& key, const Password& password);
+    private:
+        CipherSuite suite;
+        std::vector<Key> wrappedKeys;
+        std::vector<Key> salts;
+        CheckValue checkValue;
+        ExtentMap extents;
+        std::uint32_t iterations;
+        bool hasCheckValue;
+        bool hasDerivedKeys;
+        bool legacy;
+
+        // Returns false if the check value of the decrypted key does not match.
+        bool TryUnwrapKey(const std::size_t slot, const Password& password, Key& key) const;
+    };
+}
+
+#endif // FISHCODE_HEADER_HPP
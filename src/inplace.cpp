@@ -0,0 +1,473 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <system_error>
+#include <vector>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <sys/stat.h>
+#include "block.hpp"
+#include "cipher.hpp"
+#include "descriptor.hpp"
+#include "error.hpp"
+#include "file.hpp"
+#include "header.hpp"
+#include "inplace.hpp"
+#include "key.hpp"
+#include "password.hpp"
+#include "strings.hpp"
+
+namespace {
+    // Transforms chunk bytes in place, 'offset' is the position of the chunk in the data stream.
+    using TransformFunction = std::function<void(std::span<std::uint8_t> chunk, const std::uint64_t offset)>;
+
+    // Journal: magic, operation, header size, data size and chunk size (8 bytes each), then the header of the file and
+    // two record slots. A record is the sequence number, the data offset, the size and the checksum of the chunk (8
+    // bytes each) followed by its source bytes.
+    constexpr const std::array<std::uint8_t, 8> JOURNAL_MAGIC = {'F', 'C', 'J', 'O', 'U', 'R', 'N', 'L'};
+    constexpr const std::size_t JOURNAL_FIXED_SIZE = 40;
+    constexpr const std::size_t RECORD_FIXED_SIZE = 32;
+    constexpr const std::uint8_t OPERATION_DECRYPT = 'D';
+    constexpr const std::uint8_t OPERATION_ENCRYPT = 'E';
+
+    void Store64(std::uint8_t* bytes, const std::uint64_t value) noexcept {
+        // Little-endian order.
+        for (std::size_t index = 0; index < 8; index++) {
+            bytes[index] = static_cast<std::uint8_t>(value >> (index * 8));
+        }
+    }
+
+    std::uint64_t Load64(const std::uint8_t* bytes) noexcept {
+        // Little-endian order.
+        std::uint64_t value = 0;
+        for (std::size_t index = 0; index < 8; index++) {
+            value |= static_cast<std::uint64_t>(bytes[index]) << (index * 8);
+        }
+        return value;
+    }
+
+    // FNV-1a (detects a record which was not written completely).
+    std::uint64_t Checksum(std::span<const std::uint8_t> bytes, std::uint64_t hash = 14695981039346656037ULL) noexcept {
+        for (const auto byte : bytes) {
+            hash = (hash ^ byte) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    struct Record {
+        std::uint64_t sequence, offset;
+        std::vector<std::uint8_t> bytes;
+    };
+
+    class Journal {
+    public:
+        // Creates the journal (it appears under its name only when it is written completely).
+        Journal(
+            const std::filesystem::path& newFSPath,
+            const std::uint8_t newOperation,
+            std::vector<std::uint8_t> newHeader,
+            const std::uint64_t newDataSize,
+            const std::size_t newChunkSize
+        );
+
+        // Opens the journal of an interrupted task.
+        explicit Journal(const std::filesystem::path& newFSPath);
+
+        Journal(const Journal& otherJournal) = delete;
+        Journal(Journal&& otherJournal) noexcept = delete;
+
+        ~Journal() noexcept = default;
+
+        Journal& operator=(const Journal& otherJournal) = delete;
+        Journal& operator=(Journal&& otherJournal) noexcept = delete;
+
+        static inline std::uint64_t GetSize(const std::size_t headerSize, const std::size_t chunkSize) noexcept {
+            return JOURNAL_FIXED_SIZE + headerSize + 2 * (RECORD_FIXED_SIZE + chunkSize);
+        }
+
+        inline std::size_t GetChunkSize() const noexcept {
+            return chunkSize;
+        }
+
+        inline std::uint64_t GetDataSize() const noexcept {
+            return dataSize;
+        }
+
+        inline std::span<const std::uint8_t> GetHeader() const noexcept {
+            return header;
+        }
+
+        inline std::uint8_t GetOperation() const noexcept {
+            return operation;
+        }
+
+        // Returns the newest record which was written completely (its sequence number is 0 if there is none).
+        Record ReadLastRecord();
+        void Remove();
+
+        // Saves the source bytes of the chunk and waits until they are on the disk.
+        void Save(const std::uint64_t sequence, const std::uint64_t offset, std::span<const std::uint8_t> bytes);
+    private:
+        std::filesystem::path fsPath;
+        std::unique_ptr<fc::DescriptorFile> file;
+        std::uint8_t operation;
+        std::vector<std::uint8_t> header;
+        std::uint64_t dataSize;
+        std::size_t chunkSize;
+
+        inline std::uint64_t GetSlotOffset(const std::uint64_t sequence) const noexcept {
+            // Records alternate between both slots.
+            return JOURNAL_FIXED_SIZE + header.size() + (sequence % 2) * (RECORD_FIXED_SIZE + chunkSize);
+        }
+    };
+
+    Journal::Journal(
+        const std::filesystem::path& newFSPath,
+        const std::uint8_t newOperation,
+        std::vector<std::uint8_t> newHeader,
+        const std::uint64_t newDataSize,
+        const std::size_t newChunkSize
+    ) : fsPath(newFSPath), operation(newOperation), header(std::move(newHeader)), dataSize(newDataSize),
+      chunkSize(newChunkSize) {
+        // Write the journal to a temporary file.
+        const auto temporaryPath = fc::CreateTemporaryFile(fsPath, file);
+
+        // Write the fixed part and the header of the file.
+        std::vector<std::uint8_t> bytes(JOURNAL_FIXED_SIZE);
+        std::copy(JOURNAL_MAGIC.begin(), JOURNAL_MAGIC.end(), bytes.begin());
+        Store64(bytes.data() + 8, operation);
+        Store64(bytes.data() + 16, header.size());
+        Store64(bytes.data() + 24, dataSize);
+        Store64(bytes.data() + 32, chunkSize);
+        bytes.insert(bytes.end(), header.begin(), header.end());
+        file->WriteAt(bytes, 0);
+        file->Sync();
+
+        // Publish the journal (the data of the file is changed only after that).
+        std::filesystem::rename(temporaryPath, fsPath);
+        fc::SyncDirectory(fsPath);
+
+        // Reopen the journal for reading and writing of the records.
+        file = std::make_unique<fc::DescriptorFile>(fsPath, fc::FileType::FT_UPDATE);
+    }
+
+    Journal::Journal(const std::filesystem::path& newFSPath)
+    : fsPath(newFSPath), file(std::make_unique<fc::DescriptorFile>(newFSPath, fc::FileType::FT_UPDATE)) {
+        // Read the fixed part.
+        std::vector<std::uint8_t> bytes(JOURNAL_FIXED_SIZE);
+        const auto fixedSize = file->ReadAt(bytes, 0);
+        if (fixedSize != bytes.size() || !std::equal(JOURNAL_MAGIC.begin(), JOURNAL_MAGIC.end(), bytes.begin())) {
+            throw fc::error::InvalidInputFile();
+        }
+        operation = static_cast<std::uint8_t>(Load64(bytes.data() + 8));
+        const auto headerSize = Load64(bytes.data() + 16);
+        dataSize = Load64(bytes.data() + 24);
+        chunkSize = static_cast<std::size_t>(Load64(bytes.data() + 32));
+
+        // Check the sizes.
+        if (chunkSize == 0 || chunkSize > fc::File::MAX_CHUNK_SIZE || chunkSize % fc::Block::SIZE != 0) {
+            throw fc::error::InvalidInputFile();
+        }
+        const auto maxSlotsSize = fc::Header::KDF_SIZE + fc::Header::MAX_SLOTS * fc::Header::KDF_SLOT_SIZE;
+        const auto maxHeaderSize = fc::Header::FIXED_SIZE + maxSlotsSize + fc::Header::CHECK_SIZE;
+        if (headerSize < fc::Key::SIZE || headerSize > maxHeaderSize || dataSize == 0) {
+            throw fc::error::InvalidInputFile();
+        }
+
+        // Read the header of the file.
+        header.resize(static_cast<std::size_t>(headerSize));
+        if (file->ReadAt(header, JOURNAL_FIXED_SIZE) != header.size()) {
+            throw fc::error::InvalidInputFile();
+        }
+    }
+
+    Record Journal::ReadLastRecord() {
+        Record last = {0, 0, {}};
+        for (std::uint64_t slot = 0; slot < 2; slot++) {
+            // Read the fixed part of the record (an empty slot is not written yet).
+            std::array<std::uint8_t, RECORD_FIXED_SIZE> fixed;
+            if (file->ReadAt(fixed, GetSlotOffset(slot)) != fixed.size()) {
+                continue;
+            }
+            const auto sequence = Load64(fixed.data());
+            const auto offset = Load64(fixed.data() + 8);
+            const auto size = Load64(fixed.data() + 16);
+
+            // Check the record.
+            if (sequence <= last.sequence || size == 0 || size > chunkSize || offset > dataSize - size) {
+                continue;
+            }
+            std::vector<std::uint8_t> bytes(static_cast<std::size_t>(size));
+            if (file->ReadAt(bytes, GetSlotOffset(slot) + RECORD_FIXED_SIZE) != bytes.size()) {
+                continue;
+            }
+            const auto checksum = Checksum(bytes, Checksum(std::span<const std::uint8_t>(fixed).first(24)));
+            if (checksum != Load64(fixed.data() + 24)) {
+                continue;
+            }
+
+            // Keep the newest record.
+            last = {sequence, offset, std::move(bytes)};
+        }
+        return last;
+    }
+
+    void Journal::Remove() {
+        // Close and remove the journal.
+        file.reset();
+        std::filesystem::remove(fsPath);
+        fc::SyncDirectory(fsPath);
+    }
+
+    void Journal::Save(const std::uint64_t sequence, const std::uint64_t offset, std::span<const std::uint8_t> bytes) {
+        // Prepare the fixed part of the record.
+        std::array<std::uint8_t, RECORD_FIXED_SIZE> fixed;
+        Store64(fixed.data(), sequence);
+        Store64(fixed.data() + 8, offset);
+        Store64(fixed.data() + 16, bytes.size());
+        Store64(fixed.data() + 24, Checksum(bytes, Checksum(std::span<const std::uint8_t>(fixed).first(24))));
+
+        // Write the record to its slot (the other slot keeps the previous record).
+        const auto slotOffset = GetSlotOffset(sequence);
+        file->WriteAt(fixed, slotOffset);
+        file->WriteAt(bytes, slotOffset + RECORD_FIXED_SIZE);
+        file->Sync();
+    }
+
+    // Only a regular file can change its size (a device can't be transformed in place, see CheckFileIO).
+    void CheckRegularFile(const fc::DescriptorFile& file) {
+        struct stat status;
+        if (fstat(file.GetDescriptor(), &status) != 0) {
+            throw std::system_error(errno, std::generic_category(), "fstat");
+        }
+        if (!S_ISREG(status.st_mode)) {
+            throw fc::error::InvalidFileIO();
+        }
+    }
+
+    // Moves the data from 'sourceBase' to 'targetBase' by chunks. The data moving to the end of the file is processed
+    // backwards, so a chunk never overwrites the data which is not processed yet. Returns false if the task is stopped.
+    bool TransformChunks(
+        fc::DescriptorFile& file,
+        Journal& journal,
+        const std::uint64_t sourceBase,
+        const std::uint64_t targetBase,
+        const TransformFunction& transform,
+        const fc::ProgressFunction& progress
+    ) {
+        const auto total = journal.GetDataSize();
+        const auto chunkSize = journal.GetChunkSize();
+        const auto count = (total + chunkSize - 1) / chunkSize;
+        const auto isBackward = targetBase > sourceBase;
+
+        // Finish the chunk in flight (its source bytes may be overwritten, so they are taken from the journal).
+        auto record = journal.ReadLastRecord();
+        if (record.sequence != 0) {
+            transform(record.bytes, record.offset);
+            file.WriteAt(record.bytes, targetBase + record.offset);
+            file.Sync();
+        }
+
+        // Process the rest of the chunks (the record of the chunk N has the sequence number N + 1).
+        std::vector<std::uint8_t> chunk(chunkSize);
+        for (auto index = record.sequence; index < count; index++) {
+            // Calculate the data offset of the chunk.
+            const auto offset = (isBackward ? count - 1 - index : index) * chunkSize;
+            const auto size = static_cast<std::size_t>(std::min<std::uint64_t>(chunkSize, total - offset));
+
+            // Report the progress and check for task abortion (the journal is kept).
+            if (!progress(isBackward ? total - offset - size : offset, total)) {
+                return false;
+            }
+
+            // Read the chunk.
+            const auto bytes = std::span<std::uint8_t>(chunk).first(size);
+            if (file.ReadAt(bytes, sourceBase + offset) != size) {
+                throw fc::error::InvalidInputFile();
+            }
+
+            // Save the source bytes before they are overwritten.
+            journal.Save(index + 1, offset, bytes);
+
+            // Transform the chunk and write it to its new place.
+            transform(bytes, offset);
+            file.WriteAt(bytes, targetBase + offset);
+            file.Sync();
+        }
+
+        // All chunks are moved.
+        return true;
+    }
+}
+
+bool fc::DecryptInPlace(
+    const std::filesystem::path& fsPath,
+    const fc::Password& password,
+    const std::size_t chunkSize,
+    const fc::ProgressFunction& progress
+) {
+    // Open the file for reading and writing (before the journal is created or opened).
+    DescriptorFile file(fsPath, FileType::FT_UPDATE);
+    CheckRegularFile(file);
+
+    // Resume the interrupted task or start a new one.
+    std::unique_ptr<Journal> journal;
+    if (HasJournal(fsPath)) {
+        journal = std::make_unique<Journal>(GetJournalPath(fsPath));
+    } else {
+        // Read the header (never a detached one) and check the password before the journal is created (the header is
+        // overwritten, so a file whose password can't be checked would be lost after a typo).
+        File headerFile(fsPath, FileType::FT_INPUT, FileBackend::FB_STREAM, std::filesystem::path());
+        const auto header = headerFile.ReadHeader();
+        if (!header.HasCheckValue()) {
+            throw error::UncheckedPassword();
+        }
+        header.UnwrapKey(password);
+
+        // There must be at least one byte of data after the header (holes of a sparse file need another file).
+        if (file.GetSize() <= header.GetSize() || header.GetExtents().IsSparse()) {
+            throw error::InvalidInputFile();
+        }
+
+        // Check if the journal fits the file system.
+        CheckFreeSpace(fsPath, Journal::GetSize(header.GetSize(), chunkSize));
+
+        // Save the header (it is overwritten by the first chunk).
+        const auto dataSize = file.GetSize() - header.GetSize();
+        const auto journalPath = GetJournalPath(fsPath);
+        journal = std::make_unique<Journal>(journalPath, OPERATION_DECRYPT, header.Serialize(), dataSize, chunkSize);
+    }
+
+    // Check if the journal belongs to the decryption task.
+    if (journal->GetOperation() != OPERATION_DECRYPT) {
+        throw error::UnfinishedTask();
+    }
+
+    // Decrypt the key and prepare the cipher of the file.
+    const auto header = Header::Parse(journal->GetHeader());
+    const Cipher cipher(header.GetSuite(), header.UnwrapKey(password));
+
+    // Move the data to the beginning of the file.
+    const auto isCompleted = TransformChunks(file, *journal, header.GetSize(), 0, [&](auto chunk, auto offset) {
+        cipher.Decrypt(chunk, offset);
+    }, progress);
+    if (!isCompleted) {
+        return false;
+    }
+
+    // Drop the rest of the file.
+    file.Truncate(journal->GetDataSize());
+    file.Sync();
+
+    // The task is completed.
+    journal->Remove();
+    return true;
+}
+
+bool fc::EncryptInPlace(
+    const std::filesystem::path& fsPath,
+    const fc::Password& password,
+    const fc::CipherSuite suite,
+    const std::size_t chunkSize,
+    const fc::ProgressFunction& progress
+) {
+    // Open the file for reading and writing (before the journal is created or opened).
+    DescriptorFile file(fsPath, FileType::FT_UPDATE);
+    CheckRegularFile(file);
+
+    // Resume the interrupted task or start a new one.
+    std::unique_ptr<Journal> journal;
+    if (HasJournal(fsPath)) {
+        journal = std::make_unique<Journal>(GetJournalPath(fsPath));
+    } else {
+        // The file must not be empty.
+        if (file.GetSize() == 0) {
+            throw error::InvalidInputFile();
+        }
+
+        // Generate encryption key and encrypt it.
+        const Header header(suite, Key::Generate(), password, Header::DEFAULT_SLOTS);
+
+        // Check if the header (the file grows) and the journal fit the file system.
+        CheckFreeSpace(fsPath, header.GetSize() + Journal::GetSize(header.GetSize(), chunkSize));
+
+        // Save the header (it is written when all the data is moved).
+        const auto journalPath = GetJournalPath(fsPath);
+        const auto dataSize = file.GetSize();
+        journal = std::make_unique<Journal>(journalPath, OPERATION_ENCRYPT, header.Serialize(), dataSize, chunkSize);
+    }
+
+    // Check if the journal belongs to the encryption task.
+    if (journal->GetOperation() != OPERATION_ENCRYPT) {
+        throw error::UnfinishedTask();
+    }
+
+    // Decrypt the key and prepare the cipher of the file.
+    const auto header = Header::Parse(journal->GetHeader());
+    const Cipher cipher(header.GetSuite(), header.UnwrapKey(password));
+
+    // Move the data after the header.
+    const auto isCompleted = TransformChunks(file, *journal, 0, header.GetSize(), [&](auto chunk, auto offset) {
+        cipher.Encrypt(chunk, offset);
+    }, progress);
+    if (!isCompleted) {
+        return false;
+    }
+
+    // Write the header in front of the data.
+    file.WriteAt(journal->GetHeader(), 0);
+    file.Sync();
+
+    // The task is completed.
+    journal->Remove();
+    return true;
+}
+
+std::filesystem::path fc::GetJournalPath(const std::filesystem::path& fsPath) {
+    // The journal is stored next to the file.
+    auto journalPath = fsPath;
+    journalPath += STR_PATTERN6;
+    return journalPath;
+}
+
+bool fc::HasJournal(const std::filesystem::path& fsPath) noexcept {
+    std::error_code code;
+    return std::filesystem::exists(GetJournalPath(fsPath), code);
+}
+
+bool fc::IsSameFile(const std::filesystem::path& ifPath, const std::filesystem::path& ofPath) noexcept {
+    // A file which does not exist is not the same (no exception).
+    struct stat ifStatus, ofStatus;
+    if (stat(ifPath.c_str(), &ifStatus) != 0 || stat(ofPath.c_str(), &ofStatus) != 0) {
+        return false;
+    }
+
+    // Compare the block devices themselves (std::filesystem can't compare them), or the files.
+    if (S_ISBLK(ifStatus.st_mode) && S_ISBLK(ofStatus.st_mode)) {
+        return ifStatus.st_rdev == ofStatus.st_rdev;
+    }
+    return ifStatus.st_dev == ofStatus.st_dev && ifStatus.st_ino == ofStatus.st_ino;
+}
@@ -0,0 +1,58 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_INPLACE_HPP
+#define FISHCODE_INPLACE_HPP
+
+#include <filesystem>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include "cipher.hpp"
+#include "password.hpp"
+
+namespace fc {
+    // Called before every chunk, returns false to stop the task (it can be resumed later).
+    using ProgressFunction = std::function<bool(const std::uint64_t done, const std::uint64_t total)>;
+
+    // These functions transform the file in place through one descriptor (the data is shifted by the header size).
+    // The chunk in flight is saved in a journal next to the file, so an interrupted task (crash, power loss or
+    // cancellation) is resumed by running it again with the same password. Return false if the task is stopped.
+    // A file without the check value is never decrypted in place (error::UncheckedPassword), a file which is not a
+    // regular one (e.g., a device) is never transformed in place (error::InvalidFileIO).
+    bool DecryptInPlace(
+        const std::filesystem::path& fsPath,
+        const Password& password,
+        const std::size_t chunkSize,
+        const ProgressFunction& progress
+    );
+    bool EncryptInPlace(
+        const std::filesystem::path& fsPath,
+        const Password& password,
+        const CipherSuite suite,
+        const std::size_t chunkSize,
+        const ProgressFunction& progress
+    );
+
+    std::filesystem::path GetJournalPath(const std::filesystem::path& fsPath);
+    bool HasJournal(const std::filesystem::path& fsPath) noexcept;
+    bool IsSameFile(const std::filesystem::path& ifPath, const std::filesystem::path& ofPath) noexcept;
+}
+
+#endif // FISHCODE_INPLACE_HPP
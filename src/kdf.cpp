@@ -0,0 +1,208 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <string.h>
+#include "kdf.hpp"
+#include "key.hpp"
+#include "password.hpp"
+
+namespace {
+    constexpr const std::size_t BLOCK_SIZE = 64;
+    constexpr const std::size_t DIGEST_SIZE = 32;
+
+    using Digest = std::array<std::uint8_t, DIGEST_SIZE>;
+    using State = std::array<std::uint32_t, 8>;
+
+    constexpr const State INITIAL_STATE = {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+    };
+
+    constexpr const std::array<std::uint32_t, 64> ROUND_CONSTANTS = {
+        0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+        0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+        0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+        0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+        0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+        0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+        0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+        0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+    };
+
+    inline std::uint32_t RotateRight(const std::uint32_t value, const int count) noexcept {
+        return (value >> count) | (value << (32 - count));
+    }
+
+    void Compress(State& state, const std::uint8_t* block) noexcept {
+        // Message schedule (big-endian words).
+        std::array<std::uint32_t, 64> words;
+        for (std::size_t index = 0; index < 16; index++) {
+            words[index] = static_cast<std::uint32_t>(block[index * 4]) << 24
+                | static_cast<std::uint32_t>(block[index * 4 + 1]) << 16
+                | static_cast<std::uint32_t>(block[index * 4 + 2]) << 8
+                | static_cast<std::uint32_t>(block[index * 4 + 3]);
+        }
+        for (std::size_t index = 16; index < 64; index++) {
+            const auto low = words[index - 15], high = words[index - 2];
+            const auto sigma0 = RotateRight(low, 7) ^ RotateRight(low, 18) ^ (low >> 3);
+            const auto sigma1 = RotateRight(high, 17) ^ RotateRight(high, 19) ^ (high >> 10);
+            words[index] = words[index - 16] + sigma0 + words[index - 7] + sigma1;
+        }
+
+        // Rounds.
+        auto [a, b, c, d, e, f, g, h] = state;
+        for (std::size_t index = 0; index < 64; index++) {
+            const auto sum1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+            const auto choice = (e & f) ^ (~e & g);
+            const auto first = h + sum1 + choice + ROUND_CONSTANTS[index] + words[index];
+            const auto sum0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+            const auto majority = (a & b) ^ (a & c) ^ (b & c);
+            const auto second = sum0 + majority;
+            h = g;
+            g = f;
+            f = e;
+            e = d + first;
+            d = c;
+            c = b;
+            b = a;
+            a = first + second;
+        }
+
+        // Add the result to the state.
+        const State result = {a, b, c, d, e, f, g, h};
+        for (std::size_t index = 0; index < state.size(); index++) {
+            state[index] += result[index];
+        }
+    }
+
+    // SHA-256 of a message which continues 'state' after 'prefixSize' bytes (whole blocks) were compressed.
+    Digest Finish(State state, std::span<const std::uint8_t> message, const std::uint64_t prefixSize) noexcept {
+        // Compress the whole blocks of the message.
+        std::size_t done = 0;
+        for (; message.size() - done >= BLOCK_SIZE; done += BLOCK_SIZE) {
+            Compress(state, message.data() + done);
+        }
+
+        // Pad the rest: 0x80, zeros and the message size in bits (big-endian).
+        std::array<std::uint8_t, 2 * BLOCK_SIZE> tail = {};
+        const auto rest = message.size() - done;
+        std::copy(message.begin() + done, message.end(), tail.begin());
+        tail[rest] = 0x80;
+        const auto tailSize = rest + 9 <= BLOCK_SIZE ? BLOCK_SIZE : 2 * BLOCK_SIZE;
+        const auto bits = (prefixSize + message.size()) * 8;
+        for (std::size_t index = 0; index < 8; index++) {
+            tail[tailSize - 1 - index] = static_cast<std::uint8_t>(bits >> (index * 8));
+        }
+        for (std::size_t offset = 0; offset < tailSize; offset += BLOCK_SIZE) {
+            Compress(state, tail.data() + offset);
+        }
+
+        // Store the state (big-endian words).
+        Digest digest;
+        for (std::size_t index = 0; index < state.size(); index++) {
+            for (std::size_t byte = 0; byte < 4; byte++) {
+                digest[index * 4 + byte] = static_cast<std::uint8_t>(state[index] >> (24 - byte * 8));
+            }
+        }
+        return digest;
+    }
+
+    // HMAC-SHA-256 with the key blocks compressed once (every iteration of PBKDF2 needs only two more blocks).
+    class Hmac {
+    public:
+        explicit Hmac(std::span<const std::uint8_t> key) noexcept
+        : innerState(INITIAL_STATE), outerState(INITIAL_STATE) {
+            // Long keys are hashed first.
+            std::array<std::uint8_t, BLOCK_SIZE> keyBlock = {};
+            if (key.size() > BLOCK_SIZE) {
+                const auto digest = Finish(INITIAL_STATE, key, 0);
+                std::copy(digest.begin(), digest.end(), keyBlock.begin());
+            } else {
+                std::copy(key.begin(), key.end(), keyBlock.begin());
+            }
+
+            // Compress the inner and the outer key blocks.
+            std::array<std::uint8_t, BLOCK_SIZE> padded;
+            for (std::size_t index = 0; index < BLOCK_SIZE; index++) {
+                padded[index] = keyBlock[index] ^ 0x36;
+            }
+            Compress(innerState, padded.data());
+            for (std::size_t index = 0; index < BLOCK_SIZE; index++) {
+                padded[index] = keyBlock[index] ^ 0x5C;
+            }
+            Compress(outerState, padded.data());
+
+            // Do not leave the key in memory.
+            explicit_bzero(keyBlock.data(), keyBlock.size());
+            explicit_bzero(padded.data(), padded.size());
+        }
+
+        Digest Compute(std::span<const std::uint8_t> message) const noexcept {
+            const auto inner = Finish(innerState, message, BLOCK_SIZE);
+            return Finish(outerState, inner, BLOCK_SIZE);
+        }
+    private:
+        State innerState, outerState;
+    };
+}
+
+void fc::DeriveBytes(
+    std::span<const std::uint8_t> password,
+    std::span<const std::uint8_t> salt,
+    const std::uint32_t iterations,
+    std::span<std::uint8_t> derived
+) {
+    const Hmac hmac(password);
+
+    // Every block of the output is computed separately (block index starts from 1).
+    std::vector<std::uint8_t> message(salt.begin(), salt.end());
+    message.resize(salt.size() + 4);
+    for (std::size_t done = 0, index = 1; done < derived.size(); done += DIGEST_SIZE, index++) {
+        // U1 = HMAC(password, salt || index), Un = HMAC(password, Un-1), the block is U1 ^ U2 ^ ... ^ Uc.
+        for (std::size_t byte = 0; byte < 4; byte++) {
+            message[salt.size() + byte] = static_cast<std::uint8_t>(index >> (24 - byte * 8));
+        }
+        auto current = hmac.Compute(message);
+        auto block = current;
+        for (std::uint32_t iteration = 1; iteration < iterations; iteration++) {
+            current = hmac.Compute(current);
+            for (std::size_t byte = 0; byte < DIGEST_SIZE; byte++) {
+                block[byte] ^= current[byte];
+            }
+        }
+
+        // Store the block (the last one may be partial).
+        const auto count = std::min(DIGEST_SIZE, derived.size() - done);
+        std::copy_n(block.begin(), count, derived.begin() + done);
+        explicit_bzero(block.data(), block.size());
+        explicit_bzero(current.data(), current.size());
+    }
+}
+
+fc::Key fc::DeriveKey(const fc::Password& password, const fc::Key& salt, const std::uint32_t iterations) {
+    // Derive the key from all bytes of the password (the short password repeated, see Password).
+    Key key;
+    DeriveBytes(password.GetBytes(), salt.GetBytes(), iterations, std::span<std::uint8_t>(key.GetData(), Key::SIZE));
+    return key;
+}
@@ -0,0 +1,42 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_KDF_HPP
+#define FISHCODE_KDF_HPP
+
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include "key.hpp"
+#include "password.hpp"
+
+namespace fc {
+    // PBKDF2 with HMAC-SHA-256 (RFC 8018), 'derived' is filled with the first bytes of the output.
+    void DeriveBytes(
+        std::span<const std::uint8_t> password,
+        std::span<const std::uint8_t> salt,
+        const std::uint32_t iterations,
+        std::span<std::uint8_t> derived
+    );
+
+    // Key encrypting one key slot, derived from the password bytes and the random salt of the slot.
+    Key DeriveKey(const Password& password, const Key& salt, const std::uint32_t iterations);
+}
+
+#endif // FISHCODE_KDF_HPP
@@ -0,0 +1,364 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <span>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "block.hpp"
+#include "compiled.hpp"
+#include "kernel.hpp"
+#include "strings.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+// Byte shuffle that swaps each pair of bytes within a 16-byte lane (most significant byte first).
+#define FISHCODE_PAIR_SWAP 14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1
+
+namespace {
+    bool SupportsSSE4() noexcept {
+        return __builtin_cpu_supports("sse4.1");
+    }
+
+    bool SupportsAVX2() noexcept {
+        return __builtin_cpu_supports("avx2");
+    }
+
+    bool SupportsAVX512() noexcept {
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    }
+
+    __attribute__((target("sse4.1")))
+    inline __m128i LoadMaskSSE4(const fc::CompiledKey& key) noexcept {
+        // Load the full block mask.
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(key.GetMask(fc::Block::SIZE).data()));
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i LoadMaskAVX2(const fc::CompiledKey& key) noexcept {
+        // Broadcast the full block mask to both 128-bit lanes.
+        const auto mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key.GetMask(fc::Block::SIZE).data()));
+        return _mm256_broadcastsi128_si256(mask);
+    }
+
+    __attribute__((target("avx512f,avx512bw")))
+    inline __m512i LoadMaskAVX512(const fc::CompiledKey& key) noexcept {
+        // Broadcast the full block mask to all four 128-bit lanes.
+        const auto mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key.GetMask(fc::Block::SIZE).data()));
+        return _mm512_maskz_broadcast_i32x4(0xFFFF, mask);
+    }
+}
+#endif
+
+#ifdef FISHCODE_VECTOR_EXTENSIONS
+namespace {
+    // One block in a portable vector register (GCC/Clang vector extensions).
+    typedef std::uint8_t BlockVector __attribute__((vector_size(fc::Block::SIZE)));
+
+    inline BlockVector LoadVector(const std::uint8_t* bytes) noexcept {
+        // Copy bytes into the vector (no alignment requirements).
+        BlockVector vector;
+        std::memcpy(&vector, bytes, sizeof(vector));
+        return vector;
+    }
+
+    inline void StoreVector(std::uint8_t* bytes, const BlockVector vector) noexcept {
+        // Copy the vector into memory (no alignment requirements).
+        std::memcpy(bytes, &vector, sizeof(vector));
+    }
+
+    inline BlockVector SwapPairs(const BlockVector vector) noexcept {
+        // Swap each pair of bytes.
+#if defined(__clang__)
+        return __builtin_shufflevector(vector, vector, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+#else
+        const BlockVector swap = {1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14};
+        return __builtin_shuffle(vector, swap);
+#endif
+    }
+
+    bool SupportsGeneric() noexcept {
+        // Compiler generates code for the target architecture.
+        return true;
+    }
+}
+#endif
+
+namespace {
+    bool SupportsScalar() noexcept {
+        // Scalar kernel runs everywhere.
+        return true;
+    }
+}
+
+namespace {
+    // Kernel registry (the best kernel first).
+    const std::array kernels = {
+#if defined(__x86_64__) || defined(__i386__)
+        fc::kernel::Kernel{
+            "avx512", SupportsAVX512, fc::kernel::DecryptBlocksAVX512, fc::kernel::EncryptBlocksAVX512
+        },
+        fc::kernel::Kernel{"avx2", SupportsAVX2, fc::kernel::DecryptBlocksAVX2, fc::kernel::EncryptBlocksAVX2},
+        fc::kernel::Kernel{"sse4", SupportsSSE4, fc::kernel::DecryptBlocksSSE4, fc::kernel::EncryptBlocksSSE4},
+#elif defined(FISHCODE_VECTOR_EXTENSIONS)
+        fc::kernel::Kernel{
+            "generic", SupportsGeneric, fc::kernel::DecryptBlocksGeneric, fc::kernel::EncryptBlocksGeneric
+        },
+#endif
+        fc::kernel::Kernel{
+            "scalar", SupportsScalar, fc::kernel::DecryptBlocksScalar, fc::kernel::EncryptBlocksScalar
+        },
+#if (defined(__x86_64__) || defined(__i386__)) && defined(FISHCODE_VECTOR_EXTENSIONS)
+        // Baseline x86 has no byte shuffle, so here the portable kernel is only for forcing and verification.
+        fc::kernel::Kernel{
+            "generic", SupportsGeneric, fc::kernel::DecryptBlocksGeneric, fc::kernel::EncryptBlocksGeneric
+        },
+#endif
+    };
+
+    const fc::kernel::Kernel* FindKernel(const std::string& name) noexcept {
+        // Look for a supported kernel with this name.
+        for (const auto& kernel : kernels) {
+            if (name == kernel.name && kernel.IsSupported()) {
+                return &kernel;
+            }
+        }
+
+        // There is no such kernel.
+        return nullptr;
+    }
+
+    const fc::kernel::Kernel* ChooseKernel() noexcept {
+        // Check if user forces a kernel (for benchmarking).
+        if (const auto forcedName = std::getenv(fc::STR_PATTERN1)) {
+            // Try to use the forced kernel.
+            if (const auto forced = FindKernel(forcedName)) {
+                return forced;
+            }
+
+            // Report invalid configuration and continue with the best kernel.
+            std::clog << fc::STR_PATTERN1 << ": " << fc::STR_ERROR0 << forcedName << std::endl;
+        }
+
+        // Use the best kernel supported by this CPU.
+        for (const auto& kernel : kernels) {
+            if (kernel.IsSupported()) {
+                return &kernel;
+            }
+        }
+
+        // Scalar kernel is always supported.
+        return FindKernel("scalar");
+    }
+
+    std::atomic<const fc::kernel::Kernel*>& GetActiveSlot() noexcept {
+        // Kernel is chosen once, at the first use.
+        static std::atomic<const fc::kernel::Kernel*> active(ChooseKernel());
+        return active;
+    }
+}
+
+const fc::kernel::Kernel& fc::kernel::GetActive() noexcept {
+    return *GetActiveSlot().load(std::memory_order_relaxed);
+}
+
+std::span<const fc::kernel::Kernel> fc::kernel::GetKernels() noexcept {
+    return kernels;
+}
+
+bool fc::kernel::SetActive(const std::string& name) noexcept {
+    // Find the kernel.
+    const auto kernel = FindKernel(name);
+
+    // Check if it is usable.
+    if (kernel == nullptr) {
+        return false;
+    }
+
+    // Replace the active kernel.
+    GetActiveSlot().store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+void fc::kernel::DecryptBlocksScalar(
+    std::uint8_t* bytes, const std::size_t count, const fc::CompiledKey& key
+) noexcept {
+    // Decrypt blocks one by one.
+    for (std::size_t current = 0; current < count; current++) {
+        key.Decrypt(bytes + current * Block::SIZE, Block::SIZE);
+    }
+}
+
+void fc::kernel::EncryptBlocksScalar(
+    std::uint8_t* bytes, const std::size_t count, const fc::CompiledKey& key
+) noexcept {
+    // Encrypt blocks one by one.
+    for (std::size_t current = 0; current < count; current++) {
+        key.Encrypt(bytes + current * Block::SIZE, Block::SIZE);
+    }
+}
+
+#ifdef FISHCODE_VECTOR_EXTENSIONS
+void fc::kernel::DecryptBlocksGeneric(
+    std::uint8_t* bytes, const std::size_t count, const fc::CompiledKey& key
+) noexcept {
+    // Prepare the mask.
+    const auto mask = LoadVector(key.GetMask(Block::SIZE).data());
+
+    // Decrypt blocks one by one: remove the mask, then swap bytes.
+    for (std::size_t current = 0; current < count; current++) {
+        const auto address = bytes + current * Block::SIZE;
+        StoreVector(address, SwapPairs(LoadVector(address) ^ mask));
+    }
+}
+
+void fc::kernel::EncryptBlocksGeneric(
+    std::uint8_t* bytes, const std::size_t count, const fc::CompiledKey& key
+) noexcept {
+    // Prepare the mask.
+    const auto mask = LoadVector(key.GetMask(Block::SIZE).data());
+
+    // Encrypt blocks one by one: swap bytes, then apply the mask.
+    for (std::size_t current = 0; current < count; current++) {
+        const auto address = bytes + current * Block::SIZE;
+        StoreVector(address, SwapPairs(LoadVector(address)) ^ mask);
+    }
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse4.1")))
+void fc::kernel::DecryptBlocksSSE4(std::uint8_t* bytes, const std::size_t count, const fc::CompiledKey& key) noexcept {
+    // Prepare the mask and the pair swap (1 block per register).
+    const auto mask = LoadMaskSSE4(key);
+    const auto swap = _mm_set_epi8(FISHCODE_PAIR_SWAP);
+
+    // Decrypt blocks one by one: remove the mask, then swap bytes.
+    for (std::size_t current = 0; current < count; current++) {
+        const auto address = reinterpret_cast<__m128i*>(bytes + current * Block::SIZE);
+        const auto data = _mm_xor_si128(_mm_loadu_si128(address), mask);
+        _mm_storeu_si128(address, _mm_shuffle_epi8(data, swap));
+    }
+}
+
+__attribute__((target("sse4.1")))
+void fc::kernel::EncryptBlocksSSE4(std::uint8_t* bytes, const std::size_t count, const fc::CompiledKey& key) noexcept {
+    // Prepare the mask and the pair swap (1 block per register).
+    const auto mask = LoadMaskSSE4(key);
+    const auto swap = _mm_set_epi8(FISHCODE_PAIR_SWAP);
+
+    // Encrypt blocks one by one: swap bytes, then apply the mask.
+    for (std::size_t current = 0; current < count; current++) {
+        const auto address = reinterpret_cast<__m128i*>(bytes + current * Block::SIZE);
+        const auto data = _mm_shuffle_epi8(_mm_loadu_si128(address), swap);
+        _mm_storeu_si128(address, _mm_xor_si128(data, mask));
+    }
+}
+
+__attribute__((target("avx2")))
+void fc::kernel::DecryptBlocksAVX2(std::uint8_t* bytes, const std::size_t count, const fc::CompiledKey& key) noexcept {
+    // Prepare the mask and the pair swap (2 blocks per register).
+    const auto mask = LoadMaskAVX2(key);
+    const auto swap = _mm256_set_epi8(FISHCODE_PAIR_SWAP, FISHCODE_PAIR_SWAP);
+
+    // Decrypt 2 blocks at a time: remove the mask, then swap bytes.
+    std::size_t current = 0;
+    for (; current + 2 <= count; current += 2) {
+        const auto address = reinterpret_cast<__m256i*>(bytes + current * Block::SIZE);
+        const auto data = _mm256_xor_si256(_mm256_loadu_si256(address), mask);
+        _mm256_storeu_si256(address, _mm256_shuffle_epi8(data, swap));
+    }
+
+    // Decrypt the rest of the blocks.
+    DecryptBlocksSSE4(bytes + current * Block::SIZE, count - current, key);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void fc::kernel::DecryptBlocksAVX512(
+    std::uint8_t* bytes, const std::size_t count, const fc::CompiledKey& key
+) noexcept {
+    // Prepare the mask and the pair swap (4 blocks per register).
+    const auto mask = LoadMaskAVX512(key);
+    const auto swap = _mm512_set_epi8(
+        FISHCODE_PAIR_SWAP, FISHCODE_PAIR_SWAP, FISHCODE_PAIR_SWAP, FISHCODE_PAIR_SWAP
+    );
+
+    // Decrypt 8 blocks at a time (two registers): remove the mask, then swap bytes.
+    std::size_t current = 0;
+    for (; current + 8 <= count; current += 8) {
+        const auto address = bytes + current * Block::SIZE;
+        const auto low = _mm512_xor_si512(_mm512_loadu_si512(address), mask);
+        const auto high = _mm512_xor_si512(_mm512_loadu_si512(address + 4 * Block::SIZE), mask);
+        _mm512_storeu_si512(address, _mm512_shuffle_epi8(low, swap));
+        _mm512_storeu_si512(address + 4 * Block::SIZE, _mm512_shuffle_epi8(high, swap));
+    }
+
+    // Decrypt the rest of the blocks.
+    DecryptBlocksAVX2(bytes + current * Block::SIZE, count - current, key);
+}
+
+__attribute__((target("avx2")))
+void fc::kernel::EncryptBlocksAVX2(std::uint8_t* bytes, const std::size_t count, const fc::CompiledKey& key) noexcept {
+    // Prepare the mask and the pair swap (2 blocks per register).
+    const auto mask = LoadMaskAVX2(key);
+    const auto swap = _mm256_set_epi8(FISHCODE_PAIR_SWAP, FISHCODE_PAIR_SWAP);
+
+    // Encrypt 2 blocks at a time: swap bytes, then apply the mask.
+    std::size_t current = 0;
+    for (; current + 2 <= count; current += 2) {
+        const auto address = reinterpret_cast<__m256i*>(bytes + current * Block::SIZE);
+        const auto data = _mm256_shuffle_epi8(_mm256_loadu_si256(address), swap);
+        _mm256_storeu_si256(address, _mm256_xor_si256(data, mask));
+    }
+
+    // Encrypt the rest of the blocks.
+    EncryptBlocksSSE4(bytes + current * Block::SIZE, count - current, key);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void fc::kernel::EncryptBlocksAVX512(
+    std::uint8_t* bytes, const std::size_t count, const fc::CompiledKey& key
+) noexcept {
+    // Prepare the mask and the pair swap (4 blocks per register).
+    const auto mask = LoadMaskAVX512(key);
+    const auto swap = _mm512_set_epi8(
+        FISHCODE_PAIR_SWAP, FISHCODE_PAIR_SWAP, FISHCODE_PAIR_SWAP, FISHCODE_PAIR_SWAP
+    );
+
+    // Encrypt 8 blocks at a time (two registers): swap bytes, then apply the mask.
+    std::size_t current = 0;
+    for (; current + 8 <= count; current += 8) {
+        const auto address = bytes + current * Block::SIZE;
+        const auto low = _mm512_shuffle_epi8(_mm512_loadu_si512(address), swap);
+        const auto high = _mm512_shuffle_epi8(_mm512_loadu_si512(address + 4 * Block::SIZE), swap);
+        _mm512_storeu_si512(address, _mm512_xor_si512(low, mask));
+        _mm512_storeu_si512(address + 4 * Block::SIZE, _mm512_xor_si512(high, mask));
+    }
+
+    // Encrypt the rest of the blocks.
+    EncryptBlocksAVX2(bytes + current * Block::SIZE, count - current, key);
+}
+#endif
@@ -0,0 +1,70 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_KERNEL_HPP
+#define FISHCODE_KERNEL_HPP
+
+#include <span>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "compiled.hpp"
+
+namespace fc {
+    namespace kernel {
+        using BlocksFunction = void (*)(std::uint8_t* bytes, const std::size_t count, const CompiledKey& key) noexcept;
+
+        // One entry of the kernel registry.
+        struct Kernel {
+            const char* name;
+            bool (*IsSupported)() noexcept;
+            BlocksFunction Decrypt;
+            BlocksFunction Encrypt;
+        };
+
+        // Kernel used by Block::EncryptBlocks/DecryptBlocks (chosen at the first call).
+        const Kernel& GetActive() noexcept;
+
+        // All known kernels, the best one first.
+        std::span<const Kernel> GetKernels() noexcept;
+
+        // Force a kernel by its name (returns false if it is unknown or not supported by this CPU).
+        bool SetActive(const std::string& name) noexcept;
+
+        // Multi-block kernels: 'bytes' points to 'count' full blocks (count * Block::SIZE bytes).
+        void DecryptBlocksScalar(std::uint8_t* bytes, const std::size_t count, const CompiledKey& key) noexcept;
+        void EncryptBlocksScalar(std::uint8_t* bytes, const std::size_t count, const CompiledKey& key) noexcept;
+
+#ifdef FISHCODE_VECTOR_EXTENSIONS
+        void DecryptBlocksGeneric(std::uint8_t* bytes, const std::size_t count, const CompiledKey& key) noexcept;
+        void EncryptBlocksGeneric(std::uint8_t* bytes, const std::size_t count, const CompiledKey& key) noexcept;
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+        void DecryptBlocksAVX2(std::uint8_t* bytes, const std::size_t count, const CompiledKey& key) noexcept;
+        void DecryptBlocksAVX512(std::uint8_t* bytes, const std::size_t count, const CompiledKey& key) noexcept;
+        void DecryptBlocksSSE4(std::uint8_t* bytes, const std::size_t count, const CompiledKey& key) noexcept;
+        void EncryptBlocksAVX2(std::uint8_t* bytes, const std::size_t count, const CompiledKey& key) noexcept;
+        void EncryptBlocksAVX512(std::uint8_t* bytes, const std::size_t count, const CompiledKey& key) noexcept;
+        void EncryptBlocksSSE4(std::uint8_t* bytes, const std::size_t count, const CompiledKey& key) noexcept;
+#endif
+    }
+}
+
+#endif // FISHCODE_KERNEL_HPP
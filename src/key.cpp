@@ -18,43 +18,24 @@
 */
 
 #include <array>
-#include <random>
-#include <utility>
 #include <cstddef>
 #include <cstdint>
 #include "key.hpp"
+#include "pool.hpp"
 
-fc::Key::Key(std::array<std::uint8_t, fc::Key::SIZE>&& newBytes) noexcept
-: fc::Block(std::move(newBytes), fc::Key::SIZE) {
+fc::Key::Key(const std::array<std::uint8_t, fc::Key::SIZE>& newBytes) noexcept
+: fc::Block(newBytes) {
 
 }
 
 fc::Key fc::Key::Generate() {
-    // Create a new random device.
-    std::random_device randomDevice;
-
-    // Use 32-bit 'Mersenne Twister' algorithm.
-    std::mt19937 generator(randomDevice());
-
-    // Configure generator to produce numbers from 0 to UINT8_MAX.
-    std::uniform_int_distribution<unsigned int> distribute(0, UINT8_MAX);
-
-    // Create a storage for the generated key bytes.
-    std::array<std::uint8_t, SIZE> generatedBytes;
-
-    // Generate key by bytes.
-    for (std::size_t counter = 0; counter < SIZE; counter++) {
-        // Produce pseudo-random number and store it.
-        generatedBytes[counter] = static_cast<std::uint8_t>(distribute(generator));
-    }
-
-    // Return generated key.
-    return Key(std::move(generatedBytes));
+    // Take a fresh key from the pool of this thread.
+    return KeyPool::GetLocal().Take();
 }
 
 fc::Key fc::Key::GetRoundKey(const int round) const {
     // Get current key bytes.
-    const auto currentBytes = GetBytes();
+    const auto& currentBytes = GetBytes();
 
     // Create a storage for the new key bytes.
     std::array<std::uint8_t, SIZE> newBytes;
@@ -68,5 +49,5 @@ fc::Key fc::Key::GetRoundKey(const int round) const {
     }
 
     // Return new round key.
-    return Key(std::move(newBytes));
+    return Key(newBytes);
 }
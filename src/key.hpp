@@ -21,6 +21,7 @@
 #define FISHCODE_KEY_HPP
 
 #include <array>
+#include <type_traits>
 #include <cstddef>
 #include <cstdint>
 #include "block.hpp"
@@ -29,11 +30,11 @@ namespace fc {
     class Key : public Block {
     public:
         Key() = default;
-        Key(std::array<std::uint8_t, SIZE>&& newBytes) noexcept;
+        Key(const std::array<std::uint8_t, SIZE>& newBytes) noexcept;
         Key(const Key& otherKey) = default;
         Key(Key&& otherKey) noexcept = default;
 
-        virtual ~Key() noexcept override = default;
+        ~Key() noexcept = default;
 
         Key& operator=(const Key& otherKey) = default;
         Key& operator=(Key&& otherKey) noexcept = default;
@@ -42,6 +43,8 @@ namespace fc {
 
         Key GetRoundKey(const int round) const;
     };
+
+    static_assert(std::is_trivially_copyable_v<Key> && sizeof(Key) == Key::SIZE);
 }
 
 #endif // FISHCODE_KEY_HPP
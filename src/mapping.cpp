@@ -0,0 +1,139 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <filesystem>
+#include <span>
+#include <system_error>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "error.hpp"
+#include "mapping.hpp"
+
+fc::MappedFile::MappedFile(const std::filesystem::path& fsPath)
+: size(0), position(0), window(nullptr), windowSize(0), windowOffset(0) {
+    // Create the file (shared mappings need read access, so it is opened for reading too).
+    fd = open(fsPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), fsPath.string());
+    }
+
+    // Check if the blocks of the file can be allocated in advance (a page without a block kills the process with
+    // SIGBUS when it is written and the disk is full).
+    if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, 1) != 0) {
+        const auto error = errno;
+        close(fd);
+        if (error == ENOSPC) {
+            throw error::NoFreeSpace();
+        }
+        throw std::system_error(EOPNOTSUPP, std::generic_category(), "fallocate");
+    }
+}
+
+fc::MappedFile::~MappedFile() noexcept {
+    // Release the window.
+    Unmap();
+
+    // Drop the reserved space which was not written.
+    if (size > position) {
+        [[maybe_unused]] const auto result = ftruncate(fd, static_cast<off_t>(position));
+    }
+
+    // Close the file.
+    close(fd);
+}
+
+std::span<std::uint8_t> fc::MappedFile::MapWriteChunk(const std::size_t count) {
+    // Extend the file if the bytes were not reserved.
+    if (position + count > size) {
+        Reserve(position + count);
+    }
+
+    // Map the bytes and move the position past them.
+    const auto bytes = Map(count);
+    position += count;
+    return std::span<std::uint8_t>(bytes, count);
+}
+
+void fc::MappedFile::Reserve(const std::uint64_t totalSize) {
+    // Allocate the blocks and set the final size of the output file at once (the data is written through the mapping).
+    const auto offset = static_cast<off_t>(size);
+    if (totalSize > size && fallocate(fd, 0, offset, static_cast<off_t>(totalSize - size)) != 0) {
+        if (errno == ENOSPC) {
+            throw error::NoFreeSpace();
+        }
+        throw std::system_error(errno, std::generic_category(), "fallocate");
+    }
+    size = std::max(size, totalSize);
+}
+
+void fc::MappedFile::Skip(const std::uint64_t count) noexcept {
+    // The output file is extended by the next write.
+    position += count;
+}
+
+void fc::MappedFile::Write(std::span<const std::uint8_t> bytes) {
+    // Copy the bytes window by window.
+    for (std::size_t done = 0; done < bytes.size();) {
+        const auto count = std::min(bytes.size() - done, WINDOW_SIZE / 2);
+        const auto chunk = MapWriteChunk(count);
+        std::copy_n(bytes.begin() + done, count, chunk.begin());
+        done += count;
+    }
+}
+
+std::uint8_t* fc::MappedFile::Map(const std::size_t count) {
+    // Check if the bytes are in the current window.
+    if (window != nullptr && position >= windowOffset && position + count <= windowOffset + windowSize) {
+        return window + (position - windowOffset);
+    }
+
+    // Release the previous window (the kernel writes shared pages back by itself).
+    Unmap();
+
+    // Start the new window at the page which contains the position.
+    const auto pageSize = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+    windowOffset = position - position % pageSize;
+    windowSize = static_cast<std::size_t>(std::min<std::uint64_t>(WINDOW_SIZE, size - windowOffset));
+    windowSize = std::max<std::size_t>(windowSize, static_cast<std::size_t>(position - windowOffset) + count);
+
+    // Map the window.
+    const auto protection = PROT_READ | PROT_WRITE;
+    const auto address = mmap(nullptr, windowSize, protection, MAP_SHARED, fd, static_cast<off_t>(windowOffset));
+    if (address == MAP_FAILED) {
+        window = nullptr;
+        throw std::system_error(errno, std::generic_category(), "mmap");
+    }
+    window = static_cast<std::uint8_t*>(address);
+
+    // Return the bytes.
+    return window + (position - windowOffset);
+}
+
+void fc::MappedFile::Unmap() noexcept {
+    // Check if there is a window.
+    if (window != nullptr) {
+        munmap(window, windowSize);
+        window = nullptr;
+    }
+}
@@ -0,0 +1,88 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_MAPPING_HPP
+#define FISHCODE_MAPPING_HPP
+
+#include <filesystem>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include "backend.hpp"
+
+namespace fc {
+    // Output file accessed through a sliding memory-mapped window (shared). Only the output is mapped: a mapped input
+    // file kills the process with SIGBUS if another program truncates it, so the input is read into the mapping.
+    class MappedFile : public Backend {
+    public:
+        // Budget of the address space for one file (a multiple of the page size).
+        static constexpr const std::size_t WINDOW_SIZE = 64 << 20;
+
+        // Throws std::system_error (EOPNOTSUPP if the file system can't allocate the blocks of the output file in
+        // advance) or error::NoFreeSpace.
+        explicit MappedFile(const std::filesystem::path& fsPath);
+        MappedFile(const MappedFile& otherFile) = delete;
+        MappedFile(MappedFile&& otherFile) noexcept = delete;
+
+        // Unmaps the window, trims the file to the written size and closes the file.
+        ~MappedFile() noexcept override;
+
+        MappedFile& operator=(const MappedFile& otherFile) = delete;
+        MappedFile& operator=(MappedFile&& otherFile) noexcept = delete;
+
+        inline std::uint64_t GetDeviceSize() const noexcept override {
+            return 0;
+        }
+
+        inline std::uint64_t GetSize() const noexcept override {
+            return size;
+        }
+
+        // Returns the next 'count' bytes (the file is extended if they were not reserved) and moves the position past
+        // them.
+        std::span<std::uint8_t> MapWriteChunk(const std::size_t count);
+
+        // The mapping is written back by the kernel (and trimmed when the file is closed).
+        inline void Flush() override {
+        }
+
+        // The file is never read.
+        inline std::size_t Read(std::span<std::uint8_t>) override {
+            return 0;
+        }
+
+        // Allocates the file up to 'totalSize' bytes (throws error::NoFreeSpace), so its mapped pages always
+        // have blocks on the disk.
+        void Reserve(const std::uint64_t totalSize);
+
+        void Skip(const std::uint64_t count) noexcept override;
+        void Write(std::span<const std::uint8_t> bytes) override;
+    private:
+        int fd;
+        std::uint64_t size, position;
+        std::uint8_t* window;
+        std::size_t windowSize;
+        std::uint64_t windowOffset;
+
+        std::uint8_t* Map(const std::size_t count);
+        void Unmap() noexcept;
+    };
+}
+
+#endif // FISHCODE_MAPPING_HPP
@@ -17,19 +17,19 @@
 ** with FishCode. If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <array>
 #include <string>
-#include <utility>
 #include <cstddef>
 #include <cstdint>
 #include "password.hpp"
 
 fc::Password::Password(const std::string& passwordString) {
-    // Get length of the string (in bytes).
-    const auto length = passwordString.length();
+    // Get length of the string (in bytes, longer strings are cut, CheckPassword rejects them anyway).
+    const auto length = std::min(passwordString.length(), SIZE);
 
-    // Create storage for the new password bytes.
-    std::array<std::uint8_t, SIZE> newBytes;
+    // Create storage for the new password bytes (an empty string gives zeros).
+    std::array<std::uint8_t, SIZE> newBytes = {};
 
     // Convert each symbol into its binary representation and store it.
     for (std::size_t index = 0; index < length; index++) {
@@ -37,7 +37,7 @@ fc::Password::Password(const std::string& passwordString) {
     }
 
     // Check if password string doesn't have maximal length.
-    if (length < SIZE) {
+    if (length != 0 && length < SIZE) {
         // Append additional bytes from the beginning.
         for (std::size_t counter = length, index = 0; counter < SIZE; counter++, index++) {
             newBytes[counter] = newBytes[index];
@@ -45,8 +45,5 @@ fc::Password::Password(const std::string& passwordString) {
     }
 
     // Store new password bytes.
-    SetBytes(std::move(newBytes));
-
-    // Configure real size of the block.
-    SetRealSize(SIZE);
+    SetBytes(newBytes);
 }
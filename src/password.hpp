@@ -21,6 +21,7 @@
 #define FISHCODE_PASSWORD_HPP
 
 #include <string>
+#include <type_traits>
 #include <cstddef>
 #include "key.hpp"
 
@@ -35,11 +36,13 @@ namespace fc {
         Password(const Password& otherPassword) = default;
         Password(Password&& otherPassword) noexcept = default;
 
-        ~Password() noexcept override = default;
+        ~Password() noexcept = default;
 
         Password& operator=(const Password& otherPassword) = default;
         Password& operator=(Password&& otherPassword) noexcept = default;
     };
+
+    static_assert(std::is_trivially_copyable_v<Password> && sizeof(Password) == Password::SIZE);
 }
 
 #endif // FISHCODE_PASSWORD_HPP
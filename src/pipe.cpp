@@ -0,0 +1,189 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <functional>
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "cipher.hpp"
+#include "descriptor.hpp"
+#include "error.hpp"
+#include "header.hpp"
+#include "key.hpp"
+#include "password.hpp"
+#include "pipe.hpp"
+#include "sparse.hpp"
+
+namespace {
+    // Transforms chunk bytes in place, 'offset' is the position of the chunk in the data stream.
+    using TransformFunction = std::function<void(std::span<std::uint8_t> chunk, const std::uint64_t offset)>;
+
+    // Capacity requested for pipes (the default limit of unprivileged processes).
+    constexpr const int PIPE_SIZE = 1 << 20;
+
+    // Zeros written in place of the holes of a sparse file.
+    constexpr const std::size_t ZERO_BUFFER_SIZE = 1 << 20;
+
+    void EnlargePipe(const int fd) noexcept {
+        // Fewer context switches between the processes of the pipeline (other descriptors are not changed).
+        struct stat status;
+        if (fstat(fd, &status) == 0 && S_ISFIFO(status.st_mode)) {
+            fcntl(fd, F_SETPIPE_SZ, PIPE_SIZE);
+        }
+    }
+
+    void WriteZeros(const int fd, const std::uint64_t count) {
+        // Pipes can't skip bytes, so the holes are written.
+        const auto zerosSize = static_cast<std::size_t>(std::min<std::uint64_t>(count, ZERO_BUFFER_SIZE));
+        const std::vector<std::uint8_t> zeros(zerosSize);
+        for (std::uint64_t done = 0; done < count;) {
+            const auto size = static_cast<std::size_t>(std::min<std::uint64_t>(count - done, zeros.size()));
+            fc::WriteFull(fd, std::span<const std::uint8_t>(zeros).first(size));
+            done += size;
+        }
+    }
+
+    // Output 'extents' of a sparse file get the data stream, zeros are written between them.
+    void TransformPipe(
+        const int inputFD,
+        const int outputFD,
+        const std::size_t chunkSize,
+        const fc::ExtentMap& extents,
+        const TransformFunction& transform
+    ) {
+        // Writes the bytes to the output extents.
+        std::size_t extentIndex = 0;
+        std::uint64_t position = 0;
+        const auto writeExtents = [&](std::span<const std::uint8_t> bytes) {
+            for (std::size_t done = 0; done < bytes.size();) {
+                // Check if the data fits the extents.
+                if (extentIndex == extents.GetExtents().size()) {
+                    throw fc::error::InvalidInputFile();
+                }
+
+                // Write the hole before the extent and the bytes which fit the extent.
+                const auto& extent = extents.GetExtents()[extentIndex];
+                WriteZeros(outputFD, extent.offset - std::min(position, extent.offset));
+                position = std::max(position, extent.offset);
+                const auto count = static_cast<std::size_t>(
+                    std::min<std::uint64_t>(bytes.size() - done, extent.offset + extent.size - position)
+                );
+                fc::WriteFull(outputFD, bytes.subspan(done, count));
+                position += count;
+                done += count;
+
+                // Move to the next extent at the end of this one.
+                if (position == extent.offset + extent.size) {
+                    extentIndex++;
+                }
+            }
+        };
+
+        // Every chunk but the last one is full, so the partial block can only be at the end of the data.
+        std::vector<std::uint8_t> chunk(chunkSize);
+        for (std::uint64_t done = 0;;) {
+            // Read the next chunk.
+            const auto bytes = std::span<std::uint8_t>(chunk).first(fc::ReadFull(inputFD, chunk));
+            if (bytes.empty()) {
+                break;
+            }
+
+            // Transform the chunk and write it.
+            transform(bytes, done);
+            if (extents.IsSparse()) {
+                writeExtents(bytes);
+            } else {
+                fc::WriteFull(outputFD, bytes);
+            }
+            done += bytes.size();
+
+            // Check for the end of the input.
+            if (bytes.size() < chunk.size()) {
+                break;
+            }
+        }
+
+        // Check if all extents are written and write the last hole.
+        if (extents.IsSparse()) {
+            if (extentIndex != extents.GetExtents().size()) {
+                throw fc::error::InvalidInputFile();
+            }
+            WriteZeros(outputFD, extents.GetSize() - position);
+        }
+    }
+}
+
+void fc::DecryptPipe(const int inputFD, const int outputFD, const fc::Password& password, const std::size_t chunkSize) {
+    // Use large pipe buffers.
+    EnlargePipe(inputFD);
+    EnlargePipe(outputFD);
+
+    // Read the fixed part of the header (or the whole legacy header).
+    std::vector<std::uint8_t> bytes(Header::FIXED_SIZE);
+    if (ReadFull(inputFD, bytes) != bytes.size()) {
+        throw error::InvalidInputFile();
+    }
+
+    // Read the rest of the header.
+    const auto headerSize = Header::GetSerializedSize(bytes);
+    bytes.resize(headerSize);
+    const auto rest = std::span<std::uint8_t>(bytes).subspan(Header::FIXED_SIZE);
+    if (ReadFull(inputFD, rest) != rest.size()) {
+        throw error::InvalidInputFile();
+    }
+
+    // Decrypt the key (a wrong password is detected here, before any data block).
+    const auto header = Header::Parse(bytes);
+    const Cipher cipher(header.GetSuite(), header.UnwrapKey(password));
+
+    // Decrypt the data by chunks (the holes of a sparse file are written as zeros).
+    TransformPipe(inputFD, outputFD, chunkSize, header.GetExtents(), [&](auto chunk, auto offset) {
+        cipher.Decrypt(chunk, offset);
+    });
+}
+
+void fc::EncryptPipe(
+    const int inputFD,
+    const int outputFD,
+    const fc::Password& password,
+    const fc::CipherSuite suite,
+    const std::size_t chunkSize
+) {
+    // Use large pipe buffers.
+    EnlargePipe(inputFD);
+    EnlargePipe(outputFD);
+
+    // Generate encryption key.
+    const auto key = Key::Generate();
+
+    // Prepare the cipher of the data.
+    const Cipher cipher(suite, key);
+
+    // Write the header (cipher suite, encrypted key, free key slots for more passwords and the check value).
+    WriteFull(outputFD, Header(suite, key, password, Header::DEFAULT_SLOTS).Serialize());
+
+    // Encrypt the data by chunks (the input of unknown length has no holes).
+    TransformPipe(inputFD, outputFD, chunkSize, ExtentMap(), [&](auto chunk, auto offset) {
+        cipher.Encrypt(chunk, offset);
+    });
+}
@@ -0,0 +1,40 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_PIPE_HPP
+#define FISHCODE_PIPE_HPP
+
+#include <cstddef>
+#include "cipher.hpp"
+#include "password.hpp"
+
+namespace fc {
+    // These functions read the input descriptor (e.g., a pipe) until its end and write the output descriptor, so the
+    // size of the data does not need to be known. The format is the same as the format of the files.
+    void DecryptPipe(const int inputFD, const int outputFD, const Password& password, const std::size_t chunkSize);
+    void EncryptPipe(
+        const int inputFD,
+        const int outputFD,
+        const Password& password,
+        const CipherSuite suite,
+        const std::size_t chunkSize
+    );
+}
+
+#endif // FISHCODE_PIPE_HPP
@@ -0,0 +1,92 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <system_error>
+#include <vector>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string.h>
+#include <sys/random.h>
+#include "key.hpp"
+#include "pool.hpp"
+
+fc::KeyPool::KeyPool()
+: fc::KeyPool(DEFAULT_CAPACITY) {
+
+}
+
+fc::KeyPool::KeyPool(const std::size_t capacity)
+: keys(std::max<std::size_t>(capacity, 1)) {
+    // Now it is empty pool (the first request fills it).
+    next = keys.size();
+}
+
+fc::KeyPool::~KeyPool() noexcept {
+    // Do not leave unused keys in memory.
+    explicit_bzero(keys.data(), keys.size() * Key::SIZE);
+}
+
+fc::KeyPool& fc::KeyPool::GetLocal() {
+    // Create the pool on the first use in this thread.
+    thread_local KeyPool pool;
+    return pool;
+}
+
+fc::Key fc::KeyPool::Take() {
+    // Check if the pool is exhausted.
+    if (next == keys.size()) {
+        Refill();
+    }
+
+    // Copy the next key.
+    const auto key = keys[next];
+
+    // Erase it from the pool (every key is used only once).
+    explicit_bzero(keys[next].GetData(), Key::SIZE);
+    next++;
+
+    // Return the key.
+    return key;
+}
+
+void fc::KeyPool::Refill() {
+    // Fill all keys at once (Key is a plain 16-byte value).
+    const auto bytes = reinterpret_cast<std::uint8_t*>(keys.data());
+    const auto total = keys.size() * Key::SIZE;
+
+    // Request random bytes (large requests may be satisfied partially).
+    for (std::size_t filled = 0; filled < total;) {
+        const auto result = getrandom(bytes + filled, total - filled, 0);
+        if (result < 0) {
+            // Retry if the call was interrupted by a signal.
+            if (errno == EINTR) {
+                continue;
+            }
+
+            // Entropy source is not available.
+            throw std::system_error(errno, std::generic_category(), "getrandom");
+        }
+        filled += static_cast<std::size_t>(result);
+    }
+
+    // Start from the first key.
+    next = 0;
+}
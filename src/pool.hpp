@@ -0,0 +1,57 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_POOL_HPP
+#define FISHCODE_POOL_HPP
+
+#include <vector>
+#include <cstddef>
+#include "key.hpp"
+
+namespace fc {
+    // Keys generated in large batches from the kernel CSPRNG ('getrandom').
+    class KeyPool {
+    public:
+        static constexpr const std::size_t DEFAULT_CAPACITY = 256;
+
+        KeyPool();
+
+        // The pool holds at least one key (a capacity of 0 selects 1).
+        KeyPool(const std::size_t capacity);
+        KeyPool(const KeyPool& otherPool) = delete;
+        KeyPool(KeyPool&& otherPool) noexcept = default;
+
+        ~KeyPool() noexcept;
+
+        KeyPool& operator=(const KeyPool& otherPool) = delete;
+        KeyPool& operator=(KeyPool&& otherPool) noexcept = default;
+
+        // Pool of the calling thread (each worker thread has its own pool, so no locks are needed).
+        static KeyPool& GetLocal();
+
+        Key Take();
+    private:
+        std::vector<Key> keys;
+        std::size_t next;
+
+        void Refill();
+    };
+}
+
+#endif // FISHCODE_POOL_HPP
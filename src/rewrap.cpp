@@ -0,0 +1,132 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "descriptor.hpp"
+#include "error.hpp"
+#include "file.hpp"
+#include "header.hpp"
+#include "password.hpp"
+#include "rewrap.hpp"
+
+namespace {
+    bool IsSlotOf(const fc::Header& header, const fc::Password& password) {
+        try {
+            header.FindSlot(password);
+            return true;
+        } catch (const fc::error::InvalidPassword&) {
+            return false;
+        }
+    }
+
+    // Reads the header, lets 'update' change it (keeping its size) and writes it back in place.
+    void UpdateHeader(const std::filesystem::path& fsPath, const std::function<void(fc::Header&)>& update) {
+        // Open the file for reading and writing (it is never truncated).
+        fc::DescriptorFile file(fsPath, fc::FileType::FT_UPDATE);
+
+        // Read the fixed part of the header (or the whole legacy header).
+        std::vector<std::uint8_t> bytes(fc::Header::FIXED_SIZE);
+        if (file.ReadAt(bytes, 0) != bytes.size()) {
+            throw fc::error::InvalidInputFile();
+        }
+
+        // Read the rest of the header.
+        const auto headerSize = fc::Header::GetSerializedSize(bytes);
+        bytes.resize(headerSize);
+        const auto rest = std::span<std::uint8_t>(bytes).subspan(fc::Header::FIXED_SIZE);
+        if (file.ReadAt(rest, fc::Header::FIXED_SIZE) != rest.size()) {
+            throw fc::error::InvalidInputFile();
+        }
+        auto header = fc::Header::Parse(bytes);
+
+        // A mistyped password would wrap a wrong key, so the header must be able to check it.
+        if (!header.HasCheckValue()) {
+            throw fc::error::UncheckedPassword();
+        }
+
+        // Change the key slots (the header keeps its size, so the data is not moved).
+        update(header);
+        const auto newBytes = header.Serialize();
+
+        // Overwrite the header and flush it to the disk.
+        file.WriteAt(newBytes, 0);
+        file.Sync();
+    }
+}
+
+void fc::AddPassword(
+    const std::filesystem::path& fsPath,
+    const fc::Password& password,
+    const fc::Password& newPassword
+) {
+    UpdateHeader(fsPath, [&](Header& header) {
+        // Decrypt the key with one of the current passwords.
+        const auto key = header.UnwrapKey(password);
+
+        // Check if the new password already has a slot.
+        if (IsSlotOf(header, newPassword)) {
+            throw error::InvalidPassword();
+        }
+
+        // Find a free slot (the header cannot grow without moving the data).
+        for (std::size_t slot = 0; slot < header.GetSlots(); slot++) {
+            if (header.IsFreeSlot(slot)) {
+                // Encrypt the key with the new password.
+                header.WrapKey(slot, key, newPassword);
+                return;
+            }
+        }
+        throw error::NoFreeKeySlot();
+    });
+}
+
+void fc::ChangePassword(
+    const std::filesystem::path& fsPath,
+    const fc::Password& oldPassword,
+    const fc::Password& newPassword
+) {
+    UpdateHeader(fsPath, [&](Header& header) {
+        // Decrypt the key with the old password (verified by the check value).
+        const auto slot = header.FindSlot(oldPassword);
+        const auto key = header.UnwrapKey(slot, oldPassword);
+
+        // Only the slot of the old password is replaced.
+        header.WrapKey(slot, key, newPassword);
+    });
+}
+
+void fc::RemovePassword(const std::filesystem::path& fsPath, const fc::Password& password) {
+    UpdateHeader(fsPath, [&](Header& header) {
+        // Find the slot of the password.
+        const auto slot = header.FindSlot(password);
+
+        // The file must stay decryptable.
+        if (header.GetUsedSlots() < 2) {
+            throw error::LastKeySlot();
+        }
+
+        // Mark the slot as free.
+        header.ClearSlot(slot);
+    });
+}
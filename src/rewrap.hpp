@@ -0,0 +1,42 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_REWRAP_HPP
+#define FISHCODE_REWRAP_HPP
+
+#include <filesystem>
+#include "password.hpp"
+
+namespace fc {
+    // These functions rewrite only the key slots of the header (in place, flushed to the disk). A header without
+    // the check value is refused (error::UncheckedPassword), a wrong password would make the file undecryptable.
+    void AddPassword(
+        const std::filesystem::path& fsPath,
+        const Password& password,
+        const Password& newPassword
+    );
+    void ChangePassword(
+        const std::filesystem::path& fsPath,
+        const Password& oldPassword,
+        const Password& newPassword
+    );
+    void RemovePassword(const std::filesystem::path& fsPath, const Password& password);
+}
+
+#endif // FISHCODE_REWRAP_HPP
@@ -0,0 +1,103 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <filesystem>
+#include <utility>
+#include <vector>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "error.hpp"
+#include "sparse.hpp"
+
+fc::ExtentMap::ExtentMap(std::vector<fc::Extent> newExtents, const std::uint64_t newSize)
+: extents(std::move(newExtents)), size(newSize) {
+    // Check the order of the extents and sum their data.
+    std::uint64_t end = 0;
+    for (const auto& extent : extents) {
+        if (extent.size == 0 || extent.offset < end || extent.offset > size || extent.size > size - extent.offset) {
+            throw error::InvalidInputFile();
+        }
+        end = extent.offset + extent.size;
+        dataSize += extent.size;
+    }
+}
+
+fc::ExtentMap fc::ExtentMap::Find(const std::filesystem::path& fsPath) {
+    // Open the file once more (the streams have no descriptor).
+    const auto fd = open(fsPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return ExtentMap();
+    }
+
+    // Only regular files have holes.
+    struct stat status;
+    if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+        close(fd);
+        return ExtentMap();
+    }
+    const auto fileSize = static_cast<std::uint64_t>(status.st_size);
+
+    // Walk the file from data to hole.
+    std::vector<Extent> extents;
+    for (std::uint64_t offset = 0; offset < fileSize;) {
+        // Find the next data (ENXIO: only a hole is left).
+        const auto dataStart = lseek(fd, static_cast<off_t>(offset), SEEK_DATA);
+        if (dataStart < 0) {
+            if (errno == ENXIO) {
+                break;
+            }
+            close(fd);
+            return ExtentMap();
+        }
+
+        // Find the end of the data (there is a hole at the end of every file).
+        const auto dataEnd = lseek(fd, dataStart, SEEK_HOLE);
+        if (dataEnd < 0) {
+            close(fd);
+            return ExtentMap();
+        }
+        const auto start = static_cast<std::uint64_t>(dataStart);
+        offset = static_cast<std::uint64_t>(dataEnd);
+
+        // Keep small holes as data.
+        if (!extents.empty() && start - (extents.back().offset + extents.back().size) < MIN_HOLE_SIZE) {
+            extents.back().size = offset - extents.back().offset;
+        } else {
+            extents.push_back({start, offset - start});
+        }
+
+        // Check if the extents fit the header.
+        if (extents.size() > MAX_EXTENTS) {
+            close(fd);
+            return ExtentMap();
+        }
+    }
+    close(fd);
+
+    // Check if there are holes worth skipping (e.g., the file system reports the whole file as data).
+    ExtentMap map(std::move(extents), fileSize);
+    if (fileSize - map.GetDataSize() < MIN_HOLE_SIZE) {
+        return ExtentMap();
+    }
+    return map;
+}
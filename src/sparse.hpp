@@ -0,0 +1,85 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_SPARSE_HPP
+#define FISHCODE_SPARSE_HPP
+
+#include <filesystem>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace fc {
+    // Bytes of a sparse file which hold data.
+    struct Extent {
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    // Data extents of a sparse file in ascending order, the rest of the file are holes (zeros). The data of the
+    // extents is stored and encrypted as one stream. An empty map (size 0) means a file without holes.
+    class ExtentMap {
+    public:
+        // Smaller holes are kept as data (fewer extents, the file system allocates whole blocks anyway).
+        static constexpr const std::uint64_t MIN_HOLE_SIZE = 64 << 10;
+
+        // Files with more extents are processed as files without holes (the extents are stored in the header).
+        static constexpr const std::size_t MAX_EXTENTS = 1 << 20;
+
+        ExtentMap() = default;
+
+        // Throws error::InvalidInputFile if the extents are not ascending or do not fit the size.
+        ExtentMap(std::vector<Extent> newExtents, const std::uint64_t newSize);
+        ExtentMap(const ExtentMap& otherMap) = default;
+        ExtentMap(ExtentMap&& otherMap) noexcept = default;
+
+        ~ExtentMap() noexcept = default;
+
+        ExtentMap& operator=(const ExtentMap& otherMap) = default;
+        ExtentMap& operator=(ExtentMap&& otherMap) noexcept = default;
+
+        // Finds the extents with SEEK_DATA/SEEK_HOLE (an empty map if the file has no holes worth skipping or
+        // the file system does not report them).
+        static ExtentMap Find(const std::filesystem::path& fsPath);
+
+        // Size of the data of all extents.
+        inline std::uint64_t GetDataSize() const noexcept {
+            return dataSize;
+        }
+
+        inline const std::vector<Extent>& GetExtents() const noexcept {
+            return extents;
+        }
+
+        // Size of the whole file (the holes included).
+        inline std::uint64_t GetSize() const noexcept {
+            return size;
+        }
+
+        inline bool IsSparse() const noexcept {
+            return size != 0;
+        }
+    private:
+        std::vector<Extent> extents;
+        std::uint64_t size = 0;
+        std::uint64_t dataSize = 0;
+    };
+}
+
+#endif // FISHCODE_SPARSE_HPP
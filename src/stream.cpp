@@ -0,0 +1,91 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <filesystem>
+#include <ios>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include "error.hpp"
+#include "file.hpp"
+#include "stream.hpp"
+
+fc::StreamFile::StreamFile(const std::filesystem::path& fsPath, const fc::FileType type)
+: isOutput(type != FileType::FT_INPUT), size(0) {
+    // Create a file (now it is empty file).
+    if (isOutput) {
+        stream.open(fsPath, std::ios::out | std::ios::binary);
+        return;
+    }
+
+    // Open a file.
+    stream.open(fsPath, std::ios::in | std::ios::binary | std::ios::ate);
+
+    // Calculate size of the file.
+    size = static_cast<std::uint64_t>(stream.tellg());
+
+    // Rewind the stream.
+    stream.seekg(std::ios::beg);
+}
+
+void fc::StreamFile::Flush() {
+    // Write the buffered bytes of the stream.
+    stream.flush();
+
+    // Check for I/O errors (e.g., no free space).
+    if (stream.bad()) {
+        throw error::InvalidOutputFile();
+    }
+}
+
+std::size_t fc::StreamFile::Read(std::span<std::uint8_t> bytes) {
+    // Read the chunk (raw bytes) from the file.
+    stream.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+    // Check for I/O errors.
+    if (stream.bad()) {
+        throw error::InvalidInputFile();
+    }
+
+    // Return the number of bytes read (the end of the file is not an error).
+    return static_cast<std::size_t>(stream.gcount());
+}
+
+void fc::StreamFile::Skip(const std::uint64_t count) {
+    // Move the position of the stream.
+    if (stream.rdbuf()->pubseekoff(static_cast<std::streamoff>(count), std::ios::cur) != std::streampos(-1)) {
+        return;
+    }
+
+    // Check for I/O errors.
+    if (isOutput) {
+        throw error::InvalidOutputFile();
+    }
+    throw error::InvalidInputFile();
+}
+
+void fc::StreamFile::Write(std::span<const std::uint8_t> bytes) {
+    // Write chunk bytes to the file.
+    stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+    // Check for I/O errors (e.g., no free space).
+    if (!stream) {
+        throw error::InvalidOutputFile();
+    }
+}
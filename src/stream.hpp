@@ -0,0 +1,66 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_STREAM_HPP
+#define FISHCODE_STREAM_HPP
+
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include "backend.hpp"
+
+namespace fc {
+    enum class FileType;
+
+    // File accessed through the standard stream (the default backend).
+    class StreamFile : public Backend {
+    public:
+        StreamFile(const std::filesystem::path& fsPath, const FileType type);
+        StreamFile(const StreamFile& otherFile) = delete;
+        StreamFile(StreamFile&& otherFile) noexcept = delete;
+
+        ~StreamFile() noexcept override = default;
+
+        StreamFile& operator=(const StreamFile& otherFile) = delete;
+        StreamFile& operator=(StreamFile&& otherFile) noexcept = delete;
+
+        inline std::uint64_t GetDeviceSize() const noexcept override {
+            return 0;
+        }
+
+        inline std::uint64_t GetSize() const noexcept override {
+            return size;
+        }
+
+        // Throws error::InvalidOutputFile on I/O errors (e.g., no free space).
+        void Flush() override;
+
+        std::size_t Read(std::span<std::uint8_t> bytes) override;
+        void Skip(const std::uint64_t count) override;
+        void Write(std::span<const std::uint8_t> bytes) override;
+    private:
+        std::fstream stream;
+        bool isOutput;
+        std::uint64_t size;
+    };
+}
+
+#endif // FISHCODE_STREAM_HPP
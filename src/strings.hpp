@@ -26,6 +26,14 @@ namespace fc {
     constexpr const auto STR_CAPTION2 = "Set an output file";
     constexpr const auto STR_CAPTION3 = "Fatal error!";
     constexpr const auto STR_CAPTION4 = "Error!";
+    constexpr const auto STR_CAPTION5 = "Passwords";
+    constexpr const auto STR_COMMAND0 = "change-password";
+    constexpr const auto STR_COMMAND1 = "add-password";
+    constexpr const auto STR_COMMAND2 = "remove-password";
+    constexpr const auto STR_COMMAND3 = "encrypt-in-place";
+    constexpr const auto STR_COMMAND4 = "decrypt-in-place";
+    constexpr const auto STR_COMMAND5 = "encrypt-stream";
+    constexpr const auto STR_COMMAND6 = "decrypt-stream";
     constexpr const auto STR_COPYRIGHT = "Copyright (C) 2025 Vitaliy Tarasenko.";
     constexpr const auto STR_DESCRYPTION =
         "FishCode (fishcode) is a program for encrypting and decrypting files.\n\nFishCode is free software: you can "
@@ -38,15 +46,27 @@ namespace fc {
     constexpr const auto STR_DOCUMENTATION =
         "\tFishCode interface consists of two main components: the main window and an additional menu called "
         "\"More...\".\n\n\tThe main window has three input fields (\"Input file\", \"Output file\", \"Password\") and "
-        "five buttons (\"Choose...\", \"Set...\", \"Encrypt\", \"Decrypt\", \"Cancel\").\n\n\t\"Input file\" and "
+        "seven buttons (\"Choose...\", \"Set...\", \"Encrypt\", \"Decrypt\", \"Rekey\", \"Password...\", "
+        "\"Cancel\").\n\n\t\"Input file\" and "
         "\"Output file\" fields are for entering path to the corresponding files on the disk.\n\n\tThe file path "
         "can be either absolute, such as \"/home/user/Documents/file\", or relative, such as \"Documents/file\"."
         "\n\n\t\"Choose...\" and \"Set...\" buttons are alternative ways to identify the relevant files. These buttons "
         "bring up the corresponding dialog boxes.\n\n\t\"Encrypt\" and \"Decrypt\" buttons perform the operations "
         "corresponding to their name. Status of the operation is displayed in the progress bar and at the bottom "
-        "of the window, in the status field.\n\n\tThe \"Cancel\" button can abort encryption or decryption task."
-        "\n\n\tNote: password cannot contain spaces, non-Latin letters and symbols that are not part of the "
-        "ASCII character set.";
+        "of the window, in the status field. If both fields point to the same file, it is encrypted or decrypted in "
+        "place; an interrupted in-place task is finished by running it again with the same password.\n\n\t\"Rekey\" "
+        "button moves an encrypted file to a new random key (protected by the same password) without writing "
+        "decrypted data to the disk.\n\n\t\"Password...\" button "
+        "changes the entered password of the input file, adds one more password (up to four passwords can open one "
+        "file) or removes the entered password. Only the file header is rewritten, so it takes the same time for any "
+        "file size.\n\n\tThe \"Cancel\" button "
+        "can abort encryption, decryption or rekeying task."
+        "\n\n\tThe \"Cipher\" menu selects the algorithm for encryption. Decryption detects the algorithm of the "
+        "file automatically. A wrong password is reported at once (files created by older versions of the program "
+        "cannot be checked, so their passwords cannot be managed).\n\n\tNote: password cannot contain spaces, "
+        "non-Latin letters and symbols that are not part of the ASCII character set.";
+    constexpr const auto STR_ERROR0 = "unknown or unsupported kernel ";
+    constexpr const auto STR_INFO0 = "Cipher kernel: ";
     constexpr const auto STR_LABEL0 = "Input file:";
     constexpr const auto STR_LABEL1 = "Output file:";
     constexpr const auto STR_LABEL2 = "Choose...";
@@ -55,18 +75,53 @@ namespace fc {
     constexpr const auto STR_LABEL5 = "Encrypt";
     constexpr const auto STR_LABEL6 = "Decrypt";
     constexpr const auto STR_LABEL7 = "Cancel";
+    constexpr const auto STR_LABEL8 = "Rekey";
+    constexpr const auto STR_LABEL9 = "Password...";
     constexpr const auto STR_NAME0 = "FishCode";
     constexpr const auto STR_NAME1 = "More...";
     constexpr const auto STR_NAME2 = "About";
     constexpr const auto STR_NAME3 = "Help";
+    constexpr const auto STR_NAME4 = "Cipher";
+    constexpr const auto STR_NAME5 = "FishCode (15 rounds)";
+    constexpr const auto STR_NAME6 = "AES-128-CTR (fast)";
+    constexpr const auto STR_NAME7 = "Change the password";
+    constexpr const auto STR_NAME8 = "Add one more password";
+    constexpr const auto STR_NAME9 = "Remove the password";
     constexpr const auto STR_PATTERN0 = "HOME";
+    constexpr const auto STR_PATTERN1 = "FISHCODE_KERNEL";
+    constexpr const auto STR_PATTERN2 = "FISHCODE_PASSWORD";
+    constexpr const auto STR_PATTERN3 = "FISHCODE_NEW_PASSWORD";
+    constexpr const auto STR_PATTERN4 = "FISHCODE_CHUNK_SIZE";
+    constexpr const auto STR_PATTERN5 = "FISHCODE_IO";
+    constexpr const auto STR_PATTERN6 = ".journal";
+    constexpr const auto STR_PATTERN7 = ".tmp";
+    constexpr const auto STR_PATTERN8 = "FISHCODE_CACHE_WINDOW";
+    constexpr const auto STR_PATTERN9 = "FISHCODE_HEADER";
+    constexpr const auto STR_PATTERN10 = "FISHCODE_SPARSE";
     constexpr const auto STR_PROMPT0 = "Get more information about the program.";
     constexpr const auto STR_PROMPT1 = "Get user documentation.";
+    constexpr const auto STR_PROMPT2 = "Encrypt files with the original FishCode algorithm (default).";
+    constexpr const auto STR_PROMPT3 = "Encrypt files with AES-128 in counter mode (uses AES-NI if available).";
+    constexpr const auto STR_PROMPT4 = "Current password: ";
+    constexpr const auto STR_PROMPT5 = "New password: ";
+    constexpr const auto STR_PROMPT6 = "Enter the new password:";
+    constexpr const auto STR_PROMPT7 = "Repeat the new password:";
+    constexpr const auto STR_PROMPT8 = "The entered password (the file is unlocked with it):";
+    constexpr const auto STR_PROMPT9 = "Password: ";
     constexpr const auto STR_STATUS0 = "Ready";
     constexpr const auto STR_STATUS1 = "All done";
     constexpr const auto STR_STATUS2 = "Abort";
     constexpr const auto STR_STATUS3 = "Encrypting...";
     constexpr const auto STR_STATUS4 = "Decrypting...";
+    constexpr const auto STR_STATUS5 = "Rekeying...";
+    constexpr const auto STR_STATUS6 = "Password changed";
+    constexpr const auto STR_STATUS7 = "Password added";
+    constexpr const auto STR_STATUS8 = "Password removed";
+    constexpr const auto STR_USAGE0 =
+        "usage: fishcode change-password|add-password|remove-password|encrypt-in-place|decrypt-in-place FILE "
+        "(passwords are taken from FISHCODE_PASSWORD and FISHCODE_NEW_PASSWORD or read from the standard input)\n"
+        "       fishcode encrypt-stream|decrypt-stream (standard input to standard output, the password is taken "
+        "from FISHCODE_PASSWORD)";
     constexpr const auto STR_VERSION = "v1.0.0";
 }
 
@@ -24,13 +24,65 @@
 
 #include <atomic>
 #include <exception>
-#include <ios>
 #include <memory>
+#include <cstdint>
 #include <wx/event.h>
-#include "block.hpp"
+#include "cipher.hpp"
+#include "error.hpp"
 #include "events.hpp"
+#include "file.hpp"
+#include "header.hpp"
+#include "inplace.hpp"
 #include "key.hpp"
+#include "sparse.hpp"
 #include "task.hpp"
+#include "transform.hpp"
+
+namespace {
+    void ReportProgress(wxEvtHandler* sink, const std::uint64_t done, const std::uint64_t total, int& lastPercent) {
+        // Calculate current percentage of task completition (a task without data is completed at once).
+        const int percent = total != 0 ? static_cast<int>(done * 100 / total) : 100;
+
+        // Check if there is a valuable progress.
+        if (percent != lastPercent) {
+            // Send a message about progress update.
+            wxPostEvent(sink, fc::events::UpdateProgress(fc::events::ID_FRAME, percent));
+            lastPercent = percent;
+        }
+    }
+
+    // Streams the data of the task by chunks, reports the progress and checks for task abortion. Returns false if the
+    // task is aborted.
+    bool TransformTaskFile(
+        wxEvtHandler* sink,
+        fc::TaskData& data,
+        const std::uint64_t total,
+        const fc::TransformFunction& transform
+    ) {
+        int lastPercent = -1;
+        return fc::TransformFile(data.GetInputFile(), data.GetOutputFile(), total, data.GetChunkSize(), transform,
+            [&](auto done, auto) {
+                ReportProgress(sink, done, total, lastPercent);
+                return !fc::taskShouldCancel;
+            }
+        );
+    }
+
+    void FinishTask(wxEvtHandler* sink, fc::TaskData& data, const bool isCompleted) {
+        // Check for task abortion.
+        if (isCompleted) {
+            // Write the rest of the output file and give it its name (readers never see a partial file).
+            data.GetOutputFile().Flush();
+            data.GetOutputFile().Link();
+
+            // Notify the main thread about task completition.
+            wxPostEvent(sink, fc::events::UpdateDone(fc::events::ID_FRAME));
+        } else {
+            // Remove output file (user doesn't need it, an unnamed file is just closed).
+            data.GetOutputFile().Remove();
+        }
+    }
+}
 
 // Disable task abortion (default).
 std::atomic<bool> fc::taskShouldCancel(false);
@@ -38,75 +90,59 @@ std::atomic<bool> fc::taskShouldCancel(false);
 void fc::TaskDecrypt(wxEvtHandler* sink, std::unique_ptr<fc::TaskData> data) try {
     // Obtain user data.
     auto& inputFile = data->GetInputFile();
-    auto& outputFile = data->GetOutputFile();
     const auto& password = data->GetPassword();
 
-    // Calculate total number of full blocks in the input file.
-    const auto total = (inputFile.GetSize() - Key::SIZE) / Block::SIZE;
+    // Read the header (cipher suite and encrypted key) from the input file.
+    const auto header = inputFile.ReadHeader();
 
-    // Calculate number of partial blocks in the input file.
-    const auto partial = (inputFile.GetSize() - Key::SIZE) % Block::SIZE;
+    // Calculate size of the data in the input file (a detached header is in its own file).
+    const auto headerSize = inputFile.IsHeaderDetached() ? 0 : header.GetSize();
+    const auto total = static_cast<std::uint64_t>(inputFile.GetSize()) - headerSize;
 
-    // Read decryption (encrypted) key from the input file.
-    auto key = inputFile.ReadKey();
-
-    // Decrypt the key.
-    key.Decrypt(password);
-
-    // Calculate 1% of blocks in the input file.
-    const auto onePercent = total / 100;
-
-    // Decrypt the input file by blocks.
-    for (std::size_t current = 0; current < total; current++) {
-        // Check for task abortion.
-        if (taskShouldCancel) {
-            // Remove output file (user doesn't need it).
-            outputFile.Remove();
-
-            // Terminate the thread.
-            return;
+    // Write the data of a sparse file to its extents (the holes are recreated).
+    const auto& extents = header.GetExtents();
+    if (extents.IsSparse()) {
+        // Check if the data matches the extents.
+        if (total != extents.GetDataSize()) {
+            throw error::InvalidInputFile();
         }
+        data->GetOutputFile().SetExtents(extents);
+    }
 
-        // Read one block from the file.
-        auto block = inputFile.ReadBlock(static_cast<std::streamsize>(Block::SIZE));
+    // Decrypt the key (a wrong password is detected here, before any data block).
+    const auto key = header.UnwrapKey(password);
 
-        // Decrypt the block.
-        block.Decrypt(key);
+    // Prepare the cipher of the file.
+    const Cipher cipher(header.GetSuite(), key);
 
-        // Store block to the output file.
-        outputFile.WriteBlock(block);
+    // Decrypt the input file by chunks.
+    const auto isCompleted = TransformTaskFile(sink, *data, total, [&](auto chunk, auto offset) {
+        cipher.Decrypt(chunk, offset);
+    });
 
-        // Calculate current percentage of task completition.
-        const int percent = (current * 100) / total;
+    // Notify the main thread or remove the output file.
+    FinishTask(sink, *data, isCompleted);
+} catch (const std::exception& ex) {
+    // Notify main thread about exception in the task thread.
+    wxPostEvent(sink, events::TaskException(events::ID_FRAME, ex));
+}
 
-        // Check if there is a valuable progress.
-        if (onePercent > 0) {
-            if (current % onePercent == 0) {
-                // Send a message about progress update.
-                wxPostEvent(sink, events::UpdateProgress(fc::events::ID_FRAME, percent));
-            }
+void fc::TaskDecryptInPlace(wxEvtHandler* sink, std::unique_ptr<fc::TaskData> data) try {
+    // Decrypt the file by chunks (an aborted task keeps its journal and is resumed next time).
+    int lastPercent = -1;
+    const auto isCompleted = DecryptInPlace(
+        data->GetInPlacePath(),
+        data->GetPassword(),
+        data->GetChunkSize(),
+        [&](auto done, auto total) {
+            ReportProgress(sink, done, total, lastPercent);
+            return !taskShouldCancel;
         }
-    }
+    );
 
-    // Check if there is a partial block.
-    if (partial != 0 && !taskShouldCancel) {
-        // Read this block from the file.
-        auto block = inputFile.ReadBlock(static_cast<std::streamsize>(partial));
-
-        // Decrypt the block.
-        block.Decrypt(key);
-
-        // Store block to the output file.
-        outputFile.WriteBlock(block);
-    }
-
-    // Check for task abortion.
-    if (!taskShouldCancel) {
-        // Notify the main thread about task completition.
-        wxPostEvent(sink, events::UpdateDone(fc::events::ID_FRAME));
-    } else {
-        // Remove output file (user doesn't need it).
-        outputFile.Remove();
+    // Notify the main thread about task completition.
+    if (isCompleted) {
+        wxPostEvent(sink, events::UpdateDone(events::ID_FRAME));
     }
 } catch (const std::exception& ex) {
     // Notify main thread about exception in the task thread.
@@ -119,79 +155,95 @@ void fc::TaskEncrypt(wxEvtHandler* sink, std::unique_ptr<fc::TaskData> data) try
     auto& outputFile = data->GetOutputFile();
     const auto& password = data->GetPassword();
 
-    // Calculate total number of full blocks in the input file.
-    const auto total = inputFile.GetSize() / Block::SIZE;
+    // Find the holes of the input file if it is allowed (only the data of the extents is read, encrypted and written).
+    const auto extents = File::GetSparseSetting() ? inputFile.FindExtents() : ExtentMap();
+    inputFile.SetExtents(extents);
 
-    // Calculate number of partial blocks in the input file.
-    const auto partial = inputFile.GetSize() % Block::SIZE;
+    // Calculate size of the data in the input file.
+    const auto total = extents.IsSparse() ? extents.GetDataSize() : static_cast<std::uint64_t>(inputFile.GetSize());
 
     // Generate encryption key.
-    auto key = Key::Generate();
+    const auto key = Key::Generate();
 
-    // Encrypt the key.
-    key.Encrypt(password);
+    // Prepare the cipher of the file.
+    const Cipher cipher(data->GetSuite(), key);
 
-    // Write decryption (encrypted) key to the output file.
-    outputFile.WriteKey(key);
+    // Write the header (cipher suite, encrypted key, free key slots for more passwords, the check value and extents).
+    Header header(data->GetSuite(), key, password, Header::DEFAULT_SLOTS);
+    header.SetExtents(extents);
+    outputFile.WriteHeader(header);
 
-    // Decrypt the key.
-    key.Decrypt(password);
+    // Encrypt the input file by chunks.
+    const auto isCompleted = TransformTaskFile(sink, *data, total, [&](auto chunk, auto offset) {
+        cipher.Encrypt(chunk, offset);
+    });
 
-    // Calculate 1% of blocks in the input file.
-    const auto onePercent = total / 100;
-
-    // Encrypt the input file by blocks.
-    for (std::size_t current = 0; current < total; current++) {
-        // Check for task abortion.
-        if (taskShouldCancel) {
-            // Remove output file (user doesn't need it).
-            outputFile.Remove();
+    // Notify the main thread or remove the output file.
+    FinishTask(sink, *data, isCompleted);
+} catch (const std::exception& ex) {
+    // Notify main thread about exception in the task thread.
+    wxPostEvent(sink, events::TaskException(events::ID_FRAME, ex));
+}
 
-            // Terminate the thread.
-            return;
+void fc::TaskEncryptInPlace(wxEvtHandler* sink, std::unique_ptr<fc::TaskData> data) try {
+    // Encrypt the file by chunks (an aborted task keeps its journal and is resumed next time).
+    int lastPercent = -1;
+    const auto isCompleted = EncryptInPlace(
+        data->GetInPlacePath(),
+        data->GetPassword(),
+        data->GetSuite(),
+        data->GetChunkSize(),
+        [&](auto done, auto total) {
+            ReportProgress(sink, done, total, lastPercent);
+            return !taskShouldCancel;
         }
+    );
+
+    // Notify the main thread about task completition.
+    if (isCompleted) {
+        wxPostEvent(sink, events::UpdateDone(events::ID_FRAME));
+    }
+} catch (const std::exception& ex) {
+    // Notify main thread about exception in the task thread.
+    wxPostEvent(sink, events::TaskException(events::ID_FRAME, ex));
+}
 
-        // Read one block from the file.
-        auto block = inputFile.ReadBlock(static_cast<std::streamsize>(Block::SIZE));
+void fc::TaskRekey(wxEvtHandler* sink, std::unique_ptr<fc::TaskData> data) try {
+    // Obtain user data.
+    auto& inputFile = data->GetInputFile();
+    auto& outputFile = data->GetOutputFile();
+    const auto& password = data->GetPassword();
 
-        // Encrypt the block.
-        block.Encrypt(key);
+    // Read the header (cipher suite and encrypted key) from the input file.
+    const auto header = inputFile.ReadHeader();
 
-        // Store block to the output file.
-        outputFile.WriteBlock(block);
+    // Calculate size of the data in the input file (a detached header is in its own file).
+    const auto headerSize = inputFile.IsHeaderDetached() ? 0 : header.GetSize();
+    const auto total = static_cast<std::uint64_t>(inputFile.GetSize()) - headerSize;
 
-        // Calculate current percentage of task completition.
-        const int percent = (current * 100) / total;
+    // Decrypt the old key (a wrong password is detected here, before any data block).
+    const auto oldKey = header.UnwrapKey(password);
 
-        // Check if there is a valuable progress.
-        if (onePercent > 0) {
-            if (current % onePercent == 0) {
-                // Send a message about progress update.
-                wxPostEvent(sink, events::UpdateProgress(fc::events::ID_FRAME, percent));
-            }
-        }
-    }
+    // Generate the new key.
+    const auto newKey = Key::Generate();
 
-    // Check if there is a partial block.
-    if (partial != 0 && !taskShouldCancel) {
-        // Read this block from the file.
-        auto block = inputFile.ReadBlock(static_cast<std::streamsize>(partial));
+    // Prepare the delta between both keys (the data is never decrypted).
+    const KeyDelta delta(header.GetSuite(), oldKey, newKey);
 
-        // Encrypt the block.
-        block.Encrypt(key);
+    // Write the header (same cipher suite, number of key slots and extents, other passwords are dropped, the key
+    // slots get the current format).
+    const auto slots = header.IsLegacy() ? Header::DEFAULT_SLOTS : header.GetSlots();
+    Header newHeader(header.GetSuite(), newKey, password, slots);
+    newHeader.SetExtents(header.GetExtents());
+    outputFile.WriteHeader(newHeader);
 
-        // Store block to the output file.
-        outputFile.WriteBlock(block);
-    }
+    // Move the input file to the new key by chunks.
+    const auto isCompleted = TransformTaskFile(sink, *data, total, [&](auto chunk, auto offset) {
+        delta.Apply(chunk, offset);
+    });
 
-    // Check for task abortion.
-    if (!taskShouldCancel) {
-        // Notify the main thread about task completition.
-        wxPostEvent(sink, events::UpdateDone(fc::events::ID_FRAME));
-    } else {
-        // Remove output file (user doesn't need it).
-        outputFile.Remove();
-    }
+    // Notify the main thread or remove the output file.
+    FinishTask(sink, *data, isCompleted);
 } catch (const std::exception& ex) {
     // Notify main thread about exception in the task thread.
     wxPostEvent(sink, events::TaskException(events::ID_FRAME, ex));
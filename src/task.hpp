@@ -28,7 +28,9 @@
 #include <atomic>
 #include <filesystem>
 #include <memory>
+#include <cstddef>
 #include <wx/event.h>
+#include "cipher.hpp"
 #include "file.hpp"
 #include "password.hpp"
 
@@ -44,6 +46,14 @@ namespace fc {
         TaskData& operator=(const TaskData& otherTaskData) = delete;
         TaskData& operator=(TaskData&& otherTaskData) noexcept = default;
 
+        inline std::size_t GetChunkSize() const noexcept {
+            return chunkSize;
+        }
+
+        inline const std::filesystem::path& GetInPlacePath() const noexcept {
+            return inPlacePath;
+        }
+
         inline File& GetInputFile() noexcept {
             return inputFile;
         }
@@ -56,6 +66,15 @@ namespace fc {
             return password;
         }
 
+        inline CipherSuite GetSuite() const noexcept {
+            return suite;
+        }
+
+        inline void SetInPlaceFile(const std::filesystem::path& fsPath) {
+            // Store the path (the file is opened by the in-place task).
+            inPlacePath = fsPath;
+        }
+
         inline void SetInputFile(const std::filesystem::path& ifPath) {
             // Open the file.
             inputFile = File(ifPath, FileType::FT_INPUT);
@@ -70,15 +89,26 @@ namespace fc {
             // Convert and copy password.
             password = Password(passwordString);
         }
+
+        inline void SetSuite(const CipherSuite newSuite) noexcept {
+            // Store cipher suite (used for encryption only, decryption and rekeying read it from the header).
+            suite = newSuite;
+        }
     private:
         File inputFile, outputFile;
+        std::filesystem::path inPlacePath;
         Password password;
+        CipherSuite suite = CipherSuite::CS_FISHCODE;
+        std::size_t chunkSize = File::GetChunkSizeSetting();
     };
 
     extern std::atomic<bool> taskShouldCancel;
 
     void TaskDecrypt(wxEvtHandler* sink, std::unique_ptr<TaskData> data);
+    void TaskDecryptInPlace(wxEvtHandler* sink, std::unique_ptr<TaskData> data);
     void TaskEncrypt(wxEvtHandler* sink, std::unique_ptr<TaskData> data);
+    void TaskEncryptInPlace(wxEvtHandler* sink, std::unique_ptr<TaskData> data);
+    void TaskRekey(wxEvtHandler* sink, std::unique_ptr<TaskData> data);
 }
 
 #endif // FISHCODE_TASK_HPP
@@ -0,0 +1,224 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <memory>
+#include <span>
+#include <system_error>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "descriptor.hpp"
+#include "direct.hpp"
+#include "error.hpp"
+#include "file.hpp"
+#include "transform.hpp"
+#include "uring.hpp"
+
+namespace {
+    // Keeps Ring::DEPTH chunks in flight: reads ahead, transforms chunks in order and writes them behind.
+    bool TransformFileAsync(
+        fc::DescriptorFile& inputFile,
+        fc::DescriptorFile& outputFile,
+        fc::Ring& ring,
+        std::span<const std::span<std::uint8_t>> buffers,
+        const std::uint64_t total,
+        const fc::TransformFunction& transform,
+        const fc::ProgressFunction& progress
+    ) {
+        // Chunk in every buffer (read requests are tagged by buffer index, write requests by DEPTH + index).
+        struct Chunk {
+            std::uint64_t offset;
+            std::size_t size;
+            bool isRead;
+        };
+        std::array<Chunk, fc::Ring::DEPTH> chunks;
+        std::deque<unsigned> order;
+
+        // Data offsets of both files (after the headers).
+        const auto inputBase = inputFile.GetPosition();
+        const auto outputBase = outputFile.GetPosition();
+
+        // Requests the next chunk of the input file (every buffer holds one chunk).
+        const auto chunkSize = buffers.front().size();
+        std::uint64_t nextOffset = 0;
+        const auto readNext = [&](const unsigned index) {
+            const auto size = static_cast<std::size_t>(std::min<std::uint64_t>(chunkSize, total - nextOffset));
+            chunks[index] = {nextOffset, size, false};
+            ring.PrepareRead(0, index, buffers[index].first(size), inputBase + nextOffset, index);
+            order.push_back(index);
+            nextOffset += size;
+        };
+
+        // Fill all buffers.
+        for (unsigned index = 0; index < fc::Ring::DEPTH && nextOffset < total; index++) {
+            readNext(index);
+        }
+
+        // Process the chunks until all of them are written.
+        for (std::uint64_t done = 0; done < total;) {
+            // Report the progress and check for task abortion (the ring waits for the requests in flight).
+            if (!progress(done, total)) {
+                return false;
+            }
+
+            // Transform the oldest chunk as soon as it is read and write it behind.
+            if (!order.empty() && chunks[order.front()].isRead) {
+                const auto index = order.front();
+                order.pop_front();
+                const auto bytes = buffers[index].first(chunks[index].size);
+                transform(bytes, chunks[index].offset);
+                ring.PrepareWrite(1, index, bytes, outputBase + chunks[index].offset, fc::Ring::DEPTH + index);
+                continue;
+            }
+
+            // Wait for the next request (prepared requests are submitted in one batch).
+            const auto completion = ring.WaitCompletion();
+            if (completion.result < 0) {
+                throw std::system_error(-completion.result, std::generic_category(), "io_uring");
+            }
+            const auto isWrite = completion.tag >= fc::Ring::DEPTH;
+            const auto index = static_cast<unsigned>(completion.tag % fc::Ring::DEPTH);
+            const auto& chunk = chunks[index];
+            const auto bytes = buffers[index].first(chunk.size);
+            const auto count = static_cast<std::size_t>(completion.result);
+
+            // Complete a short transfer synchronously (rare for regular files).
+            if (isWrite) {
+                if (count < chunk.size) {
+                    outputFile.WriteAt(bytes.subspan(count), outputBase + chunk.offset + count);
+                }
+            } else if (count < chunk.size) {
+                const auto rest = bytes.subspan(count);
+                if (inputFile.ReadAt(rest, inputBase + chunk.offset + count) != rest.size()) {
+                    throw fc::error::InvalidInputFile();
+                }
+            }
+
+            // The chunk is read: it can be transformed.
+            if (!isWrite) {
+                chunks[index].isRead = true;
+                continue;
+            }
+
+            // The chunk is written: the buffer reads the next chunk.
+            done += chunk.size;
+            if (nextOffset < total) {
+                readNext(index);
+            }
+        }
+
+        // Move the positions of both files.
+        inputFile.Advance(total);
+        outputFile.Advance(total);
+
+        // The task is completed.
+        return progress(total, total);
+    }
+}
+
+bool fc::TransformFile(
+    fc::File& inputFile,
+    fc::File& outputFile,
+    const std::uint64_t total,
+    const std::size_t chunkSize,
+    const fc::TransformFunction& transform,
+    const fc::ProgressFunction& progress
+) {
+    // Check free space and preallocate the output file (the header is already written).
+    outputFile.Reserve(static_cast<std::uint64_t>(outputFile.GetSize()) + total);
+
+    // Sparse files skip their holes by chunks (they are not transformed in place or asynchronously).
+    const auto isSparse = inputFile.IsSparse() || outputFile.IsSparse();
+
+    // Keep many chunks in flight with io_uring.
+    if (!isSparse && inputFile.IsAsync() && outputFile.IsAsync()) {
+        // Obtain the descriptors (index 0 and 1 in the ring).
+        auto& inputDescriptor = inputFile.GetDescriptorFile();
+        auto& outputDescriptor = outputFile.GetDescriptorFile();
+        const int files[] = {inputDescriptor.GetDescriptor(), outputDescriptor.GetDescriptor()};
+
+        // Allocate the buffers (one chunk per request in flight).
+        std::vector<std::uint8_t> memory(Ring::DEPTH * chunkSize);
+        std::array<std::span<std::uint8_t>, Ring::DEPTH> buffers;
+        for (unsigned index = 0; index < Ring::DEPTH; index++) {
+            buffers[index] = std::span<std::uint8_t>(memory.data() + index * chunkSize, chunkSize);
+        }
+
+        // Create the ring (declared after the buffers, so it waits for the requests before they are released). The
+        // kernel may refuse it even if it has io_uring (e.g., seccomp or a container), the same descriptors are read
+        // and written synchronously then.
+        std::unique_ptr<Ring> ring;
+        try {
+            ring = std::make_unique<Ring>(files, buffers);
+        } catch (const std::system_error&) {
+            // Fall back to the synchronous loop below.
+        }
+        if (ring) {
+            return TransformFileAsync(inputDescriptor, outputDescriptor, *ring, buffers, total, transform, progress);
+        }
+    }
+
+    // The input file is read straight into the mapped output file and transformed there (no buffer is needed).
+    const auto isMapped = !isSparse && outputFile.IsMapped();
+
+    // Allocate the chunk buffer (whole blocks, so only the last chunk has a partial block; aligned for direct I/O).
+    const AlignedBuffer buffer(isMapped ? 0 : chunkSize);
+    const auto chunk = std::span<std::uint8_t>(buffer.GetData(), buffer.GetSize());
+
+    // Process the input file by chunks.
+    for (std::uint64_t done = 0; done < total;) {
+        // Report the progress and check for task abortion.
+        if (!progress(done, total)) {
+            return false;
+        }
+
+        // Get the next chunk of the output file.
+        std::span<std::uint8_t> bytes;
+        if (isMapped) {
+            // Read the input bytes straight into the mapped output file.
+            const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(chunkSize, total - done));
+            bytes = outputFile.MapWriteChunk(count);
+            if (inputFile.ReadChunk(bytes) != count) {
+                throw error::InvalidInputFile();
+            }
+        } else {
+            // Read the next chunk from the input file.
+            bytes = chunk.first(inputFile.ReadChunk(chunk));
+        }
+        if (bytes.empty()) {
+            throw error::InvalidInputFile();
+        }
+
+        // Transform the chunk.
+        transform(bytes, done);
+
+        // Store the chunk to the output file (mapped chunk is already there).
+        if (!isMapped) {
+            outputFile.WriteChunk(bytes);
+        }
+        done += bytes.size();
+    }
+
+    // The task is completed.
+    return progress(total, total);
+}
@@ -0,0 +1,49 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef FISHCODE_TRANSFORM_HPP
+#define FISHCODE_TRANSFORM_HPP
+
+#include <functional>
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include "file.hpp"
+#include "inplace.hpp"
+
+namespace fc {
+    // Transforms chunk bytes in place, 'offset' is the position of the chunk in the data stream.
+    using TransformFunction = std::function<void(std::span<std::uint8_t> chunk, const std::uint64_t offset)>;
+
+    // Streams 'total' bytes from the input file to the output file by chunks (after their headers), the output file
+    // is preallocated first. Both files of the FB_URING backend keep many chunks in flight, they are processed
+    // synchronously if the kernel refuses to set up the ring (e.g., seccomp in a container). Returns false if the
+    // task is stopped by 'progress' (it is also called once all bytes are written).
+    bool TransformFile(
+        File& inputFile,
+        File& outputFile,
+        const std::uint64_t total,
+        const std::size_t chunkSize,
+        const TransformFunction& transform,
+        const ProgressFunction& progress
+    );
+}
+
+#endif // FISHCODE_TRANSFORM_HPP
@@ -0,0 +1,257 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <span>
+#include <system_error>
+#include <vector>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "uring.hpp"
+
+namespace {
+    int Setup(const unsigned entries, io_uring_params& params) noexcept {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    }
+
+    int Register(const int ringFD, const unsigned opcode, const void* arguments, const unsigned count) noexcept {
+        return static_cast<int>(syscall(__NR_io_uring_register, ringFD, opcode, arguments, count));
+    }
+}
+
+fc::Ring::Ring(std::span<const int> files, std::span<const std::span<std::uint8_t>> buffers)
+: sqRing(MAP_FAILED), cqRing(MAP_FAILED), sqes(nullptr), cqes(nullptr), prepared(0), pending(0),
+  descriptors(files.begin(), files.end()) {
+    // Create the ring (one request per buffer is in flight, twice as many entries leave room for batching).
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ringFD = Setup(DEPTH * 2, params);
+    if (ringFD < 0) {
+        throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+    }
+    sqEntries = params.sq_entries;
+
+    // Calculate sizes of the rings (they may share one mapping).
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const auto isSingleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (isSingleMapping) {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+
+    // Map the rings and the submission queue entries.
+    const auto protection = PROT_READ | PROT_WRITE;
+    const auto flags = MAP_SHARED | MAP_POPULATE;
+    sqRing = mmap(nullptr, sqRingSize, protection, flags, ringFD, IORING_OFF_SQ_RING);
+    if (sqRing != MAP_FAILED) {
+        cqRing = isSingleMapping ? sqRing : mmap(nullptr, cqRingSize, protection, flags, ringFD, IORING_OFF_CQ_RING);
+    }
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    const auto sqesAddress = mmap(nullptr, sqesSize, protection, flags, ringFD, IORING_OFF_SQES);
+    if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqesAddress == MAP_FAILED) {
+        const auto error = errno;
+        if (sqesAddress != MAP_FAILED) {
+            munmap(sqesAddress, sqesSize);
+        }
+        Release();
+        throw std::system_error(error, std::generic_category(), "mmap");
+    }
+    sqes = static_cast<io_uring_sqe*>(sqesAddress);
+
+    // Locate the fields of the rings.
+    const auto sqBase = static_cast<std::uint8_t*>(sqRing);
+    const auto cqBase = static_cast<std::uint8_t*>(cqRing);
+    sqHead = reinterpret_cast<unsigned*>(sqBase + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sqBase + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned*>(sqBase + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sqBase + params.sq_off.array);
+    cqHead = reinterpret_cast<unsigned*>(cqBase + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cqBase + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned*>(cqBase + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cqBase + params.cq_off.cqes);
+
+    // Register the files (requests refer to them by index, the kernel skips the descriptor lookup).
+    hasFixedFiles = Register(ringFD, IORING_REGISTER_FILES, descriptors.data(), descriptors.size()) == 0;
+
+    // Register the buffers (pinned once, may fail because of RLIMIT_MEMLOCK on older kernels).
+    std::vector<iovec> vectors;
+    for (const auto& buffer : buffers) {
+        vectors.push_back({buffer.data(), buffer.size()});
+    }
+    hasFixedBuffers = Register(ringFD, IORING_REGISTER_BUFFERS, vectors.data(), vectors.size()) == 0;
+}
+
+fc::Ring::~Ring() noexcept {
+    // Wait for the requests in flight (submit the prepared ones first).
+    try {
+        while (pending != 0 || prepared != 0) {
+            WaitCompletion();
+        }
+    } catch (...) {
+        // The ring is closed anyway.
+    }
+
+    // Unmap and close the ring (registered files and buffers are released with it).
+    Release();
+}
+
+bool fc::Ring::IsSupported() noexcept {
+    // Probe the kernel on the first call.
+    static const bool isSupported = [] {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        const auto ringFD = Setup(2, params);
+        if (ringFD < 0) {
+            return false;
+        }
+        close(ringFD);
+
+        // IORING_OP_READ/WRITE appeared together with this feature (Linux 5.6).
+        return (params.features & IORING_FEAT_RW_CUR_POS) != 0;
+    }();
+    return isSupported;
+}
+
+void fc::Ring::PrepareRead(
+    const unsigned file,
+    const unsigned buffer,
+    std::span<std::uint8_t> bytes,
+    const std::uint64_t offset,
+    const std::uint64_t tag
+) {
+    Prepare(false, file, buffer, bytes.data(), bytes.size(), offset, tag);
+}
+
+void fc::Ring::PrepareWrite(
+    const unsigned file,
+    const unsigned buffer,
+    std::span<const std::uint8_t> bytes,
+    const std::uint64_t offset,
+    const std::uint64_t tag
+) {
+    Prepare(true, file, buffer, const_cast<std::uint8_t*>(bytes.data()), bytes.size(), offset, tag);
+}
+
+fc::Ring::Completion fc::Ring::WaitCompletion() {
+    while (true) {
+        // Check the completion queue (the kernel moves its tail).
+        const auto head = *cqHead;
+        if (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            const auto& cqe = cqes[head & *cqMask];
+            const Completion completion = {cqe.user_data, cqe.res};
+            __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+            pending--;
+            return completion;
+        }
+
+        // Nothing to wait for.
+        if (pending == 0 && prepared == 0) {
+            throw std::system_error(EINVAL, std::generic_category(), "io_uring_enter");
+        }
+
+        // Submit the prepared requests and wait for one completion.
+        Enter(1);
+    }
+}
+
+void fc::Ring::Enter(const unsigned minComplete) {
+    // Submit all prepared requests in one system call.
+    while (true) {
+        const auto flags = minComplete != 0 ? IORING_ENTER_GETEVENTS : 0;
+        const auto result = syscall(__NR_io_uring_enter, ringFD, prepared, minComplete, flags, nullptr, 0);
+        if (result < 0) {
+            // Retry if the call was interrupted by a signal.
+            if (errno == EINTR) {
+                continue;
+            }
+
+            throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+        }
+
+        // Submitted requests are in flight now.
+        prepared -= static_cast<unsigned>(result);
+        pending += static_cast<unsigned>(result);
+        return;
+    }
+}
+
+void fc::Ring::Prepare(
+    const bool isWrite,
+    const unsigned file,
+    const unsigned buffer,
+    std::uint8_t* bytes,
+    const std::size_t count,
+    const std::uint64_t offset,
+    const std::uint64_t tag
+) {
+    // Submit the prepared requests if the submission queue is full.
+    const auto tail = *sqTail;
+    if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+        Enter(0);
+    }
+
+    // Fill the entry.
+    const auto index = tail & *sqMask;
+    auto& sqe = sqes[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    if (hasFixedBuffers) {
+        sqe.opcode = isWrite ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe.buf_index = static_cast<std::uint16_t>(buffer);
+    } else {
+        sqe.opcode = isWrite ? IORING_OP_WRITE : IORING_OP_READ;
+    }
+    if (hasFixedFiles) {
+        sqe.fd = static_cast<std::int32_t>(file);
+        sqe.flags = IOSQE_FIXED_FILE;
+    } else {
+        sqe.fd = descriptors[file];
+    }
+    sqe.addr = reinterpret_cast<std::uint64_t>(bytes);
+    sqe.len = static_cast<std::uint32_t>(count);
+    sqe.off = offset;
+    sqe.user_data = tag;
+
+    // Publish the entry (the kernel reads the tail).
+    sqArray[index] = index;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    prepared++;
+}
+
+void fc::Ring::Release() noexcept {
+    // Unmap the rings.
+    if (sqes != nullptr) {
+        munmap(sqes, sqesSize);
+    }
+    if (cqRing != MAP_FAILED && cqRing != sqRing) {
+        munmap(cqRing, cqRingSize);
+    }
+    if (sqRing != MAP_FAILED) {
+        munmap(sqRing, sqRingSize);
+    }
+
+    // Close the ring.
+    close(ringFD);
+}
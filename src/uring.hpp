@@ -0,0 +1,106 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_URING_HPP
+#define FISHCODE_URING_HPP
+
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+struct io_uring_cqe;
+struct io_uring_sqe;
+
+namespace fc {
+    // io_uring instance (raw system calls, no liburing) with fixed files and registered buffers when possible.
+    class Ring {
+    public:
+        // Number of chunks in flight.
+        static constexpr const unsigned DEPTH = 8;
+
+        struct Completion {
+            std::uint64_t tag;
+            std::int32_t result;
+        };
+
+        Ring(std::span<const int> files, std::span<const std::span<std::uint8_t>> buffers);
+        Ring(const Ring& otherRing) = delete;
+        Ring(Ring&& otherRing) noexcept = delete;
+
+        // Waits for all requests in flight (they use the caller's buffers).
+        ~Ring() noexcept;
+
+        Ring& operator=(const Ring& otherRing) = delete;
+        Ring& operator=(Ring&& otherRing) noexcept = delete;
+
+        // Checks once if the kernel has io_uring (with IORING_OP_READ/WRITE).
+        static bool IsSupported() noexcept;
+
+        // 'file' and 'buffer' are indexes in the registered lists, 'bytes' must be inside the buffer.
+        void PrepareRead(
+            const unsigned file,
+            const unsigned buffer,
+            std::span<std::uint8_t> bytes,
+            const std::uint64_t offset,
+            const std::uint64_t tag
+        );
+        void PrepareWrite(
+            const unsigned file,
+            const unsigned buffer,
+            std::span<const std::uint8_t> bytes,
+            const std::uint64_t offset,
+            const std::uint64_t tag
+        );
+
+        // Submits all prepared requests at once and returns the next completion (waits for it if needed).
+        Completion WaitCompletion();
+    private:
+        int ringFD;
+        void* sqRing;
+        void* cqRing;
+        io_uring_sqe* sqes;
+        io_uring_cqe* cqes;
+        std::size_t sqRingSize, cqRingSize, sqesSize;
+        unsigned* sqHead;
+        unsigned* sqTail;
+        unsigned* sqMask;
+        unsigned* sqArray;
+        unsigned* cqHead;
+        unsigned* cqTail;
+        unsigned* cqMask;
+        unsigned sqEntries, prepared, pending;
+        std::vector<int> descriptors;
+        bool hasFixedFiles, hasFixedBuffers;
+
+        void Enter(const unsigned minComplete);
+        void Prepare(
+            const bool isWrite,
+            const unsigned file,
+            const unsigned buffer,
+            std::uint8_t* bytes,
+            const std::size_t count,
+            const std::uint64_t offset,
+            const std::uint64_t tag
+        );
+        void Release() noexcept;
+    };
+}
+
+#endif // FISHCODE_URING_HPP
@@ -0,0 +1,111 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "aes.hpp"
+#include "block.hpp"
+#include "check.hpp"
+#include "cipher.hpp"
+#include "key.hpp"
+
+namespace {
+    // Data of several bulk iterations (4 blocks each) and a partial block.
+    constexpr const std::size_t DATA_SIZE = 1000;
+
+    std::vector<std::uint8_t> MakeBytes(const std::size_t length) {
+        // Every byte depends on its position.
+        std::vector<std::uint8_t> bytes(length);
+        for (std::size_t index = 0; index < length; index++) {
+            bytes[index] = static_cast<std::uint8_t>(index * 131 + 7);
+        }
+        return bytes;
+    }
+
+    void CheckBlock() {
+        // FIPS-197, appendix C.1 (AES-128).
+        std::array<std::uint8_t, fc::Key::SIZE> keyBytes;
+        std::array<std::uint8_t, fc::Block::SIZE> plainBytes;
+        for (std::size_t index = 0; index < keyBytes.size(); index++) {
+            keyBytes[index] = static_cast<std::uint8_t>(index);
+            plainBytes[index] = static_cast<std::uint8_t>(index * 0x11);
+        }
+        const std::array<std::uint8_t, fc::Block::SIZE> cipherBytes = {
+            0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30, 0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A
+        };
+        const fc::Aes aes(fc::Key{keyBytes});
+        fc::test::Check(aes.EncryptBlock(fc::Block(plainBytes)).GetBytes() == cipherBytes, "FIPS-197 C.1");
+    }
+
+    void CheckStream(const fc::Aes& aes) {
+        // Key stream of the counter blocks (8 zero bytes and the big-endian block index).
+        std::vector<std::uint8_t> stream(DATA_SIZE);
+        aes.Crypt(stream, 0);
+        for (std::size_t offset = 0; offset < stream.size(); offset += fc::Block::SIZE) {
+            std::array<std::uint8_t, fc::Block::SIZE> counter = {};
+            const auto index = offset / fc::Block::SIZE;
+            counter[14] = static_cast<std::uint8_t>(index >> 8);
+            counter[15] = static_cast<std::uint8_t>(index);
+            const auto expected = aes.EncryptBlock(fc::Block(counter)).GetBytes();
+            const auto size = std::min(stream.size() - offset, fc::Block::SIZE);
+            fc::test::Check(
+                std::equal(expected.begin(), expected.begin() + size, stream.begin() + offset),
+                "key stream, block " + std::to_string(index)
+            );
+        }
+
+        // Any split of the data (unaligned offsets too) gives the same result as one call.
+        for (const std::size_t split : {1, 15, 16, 17, 64, 100, 999}) {
+            auto bytes = std::vector<std::uint8_t>(DATA_SIZE);
+            aes.Crypt(std::span<std::uint8_t>(bytes).first(split), 0);
+            aes.Crypt(std::span<std::uint8_t>(bytes).subspan(split), split);
+            fc::test::Check(bytes == stream, "split at " + std::to_string(split));
+        }
+    }
+
+    void CheckSuite(const fc::CipherSuite suite, const fc::Key& key) {
+        // Encrypt the data by chunks (at their offsets) and decrypt it at once.
+        const auto what = std::string("suite ") + std::to_string(static_cast<int>(suite));
+        const fc::Cipher cipher(suite, key);
+        const auto plain = MakeBytes(DATA_SIZE);
+        auto bytes = plain;
+        cipher.Encrypt(std::span<std::uint8_t>(bytes).first(512), 0);
+        cipher.Encrypt(std::span<std::uint8_t>(bytes).subspan(512), 512);
+        fc::test::Check(bytes != plain, what + " encrypts");
+        cipher.Decrypt(bytes, 0);
+        fc::test::Check(bytes == plain, what + " round trip");
+    }
+}
+
+int main() {
+    // AES itself, then the counter mode against it.
+    CheckBlock();
+    const auto key = fc::Key::Generate();
+    CheckStream(fc::Aes(key));
+
+    // Both cipher suites decrypt what they encrypt.
+    CheckSuite(fc::CipherSuite::CS_FISHCODE, key);
+    CheckSuite(fc::CipherSuite::CS_AES128_CTR, key);
+    return fc::test::GetResult();
+}
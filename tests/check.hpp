@@ -0,0 +1,72 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FISHCODE_CHECK_HPP
+#define FISHCODE_CHECK_HPP
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+namespace fc {
+    namespace test {
+        // Number of failed checks of the test program.
+        inline int failures = 0;
+
+        // Reports a failed check (the test goes on, so one run shows all failures).
+        inline void Check(const bool condition, const std::string_view what) {
+            if (!condition) {
+                std::cerr << "FAILED: " << what << std::endl;
+                failures++;
+            }
+        }
+
+        // Reports a check which does not throw 'Exception'.
+        template<typename Exception, typename Function>
+        void CheckThrows(const Function& function, const std::string_view what) {
+            try {
+                function();
+            } catch (const Exception&) {
+                return;
+            } catch (...) {
+                // Other exceptions are failures too.
+            }
+            Check(false, what);
+        }
+
+        // Reads the whole file at once.
+        inline std::vector<std::uint8_t> ReadBytes(const std::filesystem::path& fsPath) {
+            std::vector<std::uint8_t> bytes(static_cast<std::size_t>(std::filesystem::file_size(fsPath)));
+            std::ifstream(fsPath, std::ios::binary).read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+            return bytes;
+        }
+
+        // Exit status of the test program (for CTest).
+        inline int GetResult() noexcept {
+            return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+}
+
+#endif // FISHCODE_CHECK_HPP
@@ -0,0 +1,165 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "block.hpp"
+#include "check.hpp"
+#include "cipher.hpp"
+#include "error.hpp"
+#include "header.hpp"
+#include "key.hpp"
+#include "password.hpp"
+
+namespace {
+    // Few iterations keep the test fast (the format is the same).
+    constexpr const std::uint32_t ITERATIONS = 1000;
+
+    // Master key encrypted with FishCode under the password itself (the slot of the original format).
+    fc::Key WrapReference(const fc::Key& key, const fc::Password& password) {
+        fc::Block block(key.GetBytes());
+        block.Encrypt(password);
+        return fc::Key(block.GetBytes());
+    }
+
+    void CheckLegacy(const fc::Key& key, const fc::Password& password, const fc::Password& otherPassword) {
+        // The original format: the wrapped key only.
+        const auto wrappedKey = WrapReference(key, password);
+        const std::vector<std::uint8_t> bytes(wrappedKey.GetBytes().begin(), wrappedKey.GetBytes().end());
+        fc::test::Check(fc::Header::GetSerializedSize(bytes) == fc::Key::SIZE, "legacy size");
+        const auto header = fc::Header::Parse(bytes);
+        fc::test::Check(header.IsLegacy() && !header.HasCheckValue(), "legacy format");
+        fc::test::Check(header.GetSuite() == fc::CipherSuite::CS_FISHCODE, "legacy suite");
+        fc::test::Check(header.UnwrapKey(0, password).GetBytes() == key.GetBytes(), "legacy key");
+        fc::test::Check(header.Serialize() == bytes, "legacy round trip");
+
+        // The only slot can be rewrapped, but never shared with a second password.
+        auto rewrapped = header;
+        rewrapped.WrapKey(0, key, otherPassword);
+        fc::test::Check(rewrapped.UnwrapKey(0, otherPassword).GetBytes() == key.GetBytes(), "legacy rewrap");
+    }
+
+    void CheckFishCodeSlots(const fc::Key& key, const fc::Password& password, const fc::Password& otherPassword) {
+        // Tagged header with the check value and FishCode slots (two slots, the second one is free).
+        std::vector<std::uint8_t> bytes(fc::Header::FIXED_SIZE);
+        std::copy(fc::Header::MAGIC.begin(), fc::Header::MAGIC.end(), bytes.begin());
+
+        // Version, cipher suite, flags and number of key slots (no extents).
+        bytes[8] = fc::Header::VERSION;
+        bytes[9] = static_cast<std::uint8_t>(fc::CipherSuite::CS_FISHCODE);
+        bytes[10] = fc::Header::FLAG_CHECK_VALUE;
+        bytes[11] = 2;
+
+        // The used slot, the free one and the check value.
+        const auto wrappedKey = WrapReference(key, password);
+        bytes.insert(bytes.end(), wrappedKey.GetBytes().begin(), wrappedKey.GetBytes().end());
+        bytes.resize(bytes.size() + fc::Key::SIZE);
+        const auto checkValue = fc::Header::ComputeCheckValue(key);
+        bytes.insert(bytes.end(), checkValue.begin(), checkValue.end());
+
+        // The key is found by the check value.
+        auto header = fc::Header::Parse(bytes);
+        fc::test::Check(!header.IsLegacy() && header.HasCheckValue() && !header.HasDerivedKeys(), "FishCode slots");
+        fc::test::Check(header.UnwrapKey(password).GetBytes() == key.GetBytes(), "FishCode slot key");
+        fc::test::Check(header.Serialize() == bytes, "FishCode slots round trip");
+        fc::test::CheckThrows<fc::error::InvalidPassword>([&]() {
+            header.UnwrapKey(otherPassword);
+        }, "FishCode slot, wrong password");
+
+        // A second FishCode slot would reveal the XOR of the passwords.
+        fc::test::CheckThrows<fc::error::LegacyKeySlots>([&]() {
+            header.WrapKey(1, key, otherPassword);
+        }, "FishCode slots, second password");
+    }
+
+    void CheckDerivedSlots(const fc::Key& key, const fc::Password& password, const fc::Password& otherPassword) {
+        // New header: the first slot is used, the others are free.
+        fc::Header header(fc::CipherSuite::CS_AES128_CTR, key, password, fc::Header::DEFAULT_SLOTS, ITERATIONS);
+        const auto bytes = header.Serialize();
+        fc::test::Check(std::equal(fc::Header::MAGIC.begin(), fc::Header::MAGIC.end(), bytes.begin()), "magic");
+        fc::test::Check(bytes[8] == fc::Header::VERSION, "version");
+        fc::test::Check(fc::Header::GetSerializedSize(bytes) == bytes.size(), "size");
+        fc::test::Check(header.GetUsedSlots() == 1, "used slots");
+
+        // The slot never holds the key wrapped with FishCode.
+        const auto fishCodeSlot = WrapReference(key, password).GetBytes();
+        const auto found = std::search(bytes.begin(), bytes.end(), fishCodeSlot.begin(), fishCodeSlot.end());
+        fc::test::Check(found == bytes.end(), "derived slot");
+
+        // Parse the header and add a second password.
+        auto parsed = fc::Header::Parse(bytes);
+        fc::test::Check(parsed.HasDerivedKeys() && parsed.GetSuite() == fc::CipherSuite::CS_AES128_CTR, "parsed");
+        fc::test::Check(parsed.UnwrapKey(password).GetBytes() == key.GetBytes(), "derived key");
+        parsed.WrapKey(1, key, otherPassword);
+        const auto reparsed = fc::Header::Parse(parsed.Serialize());
+        fc::test::Check(reparsed.FindSlot(otherPassword) == 1, "second slot");
+        fc::test::Check(reparsed.UnwrapKey(otherPassword).GetBytes() == key.GetBytes(), "second password");
+        fc::test::Check(reparsed.UnwrapKey(password).GetBytes() == key.GetBytes(), "first password");
+
+        // The same password gets different slots (random salts).
+        parsed.WrapKey(2, key, password);
+        fc::test::Check(parsed.Serialize() != bytes, "salted slots");
+
+        // A cleared slot no longer opens the file.
+        auto cleared = reparsed;
+        cleared.ClearSlot(0);
+        fc::test::CheckThrows<fc::error::InvalidPassword>([&]() {
+            cleared.UnwrapKey(password);
+        }, "cleared slot");
+    }
+
+    void CheckInvalid(const fc::Key& key, const fc::Password& password) {
+        // Truncated header.
+        const fc::Header header(fc::CipherSuite::CS_FISHCODE, key, password, 1, ITERATIONS);
+        const auto bytes = header.Serialize();
+        fc::test::CheckThrows<fc::error::InvalidInputFile>([&]() {
+            fc::Header::Parse(std::span<const std::uint8_t>(bytes).first(bytes.size() - 1));
+        }, "truncated header");
+
+        // No iterations.
+        auto corrupted = bytes;
+        std::fill_n(corrupted.begin() + fc::Header::FIXED_SIZE, fc::Header::KDF_SIZE, 0);
+        fc::test::CheckThrows<fc::error::InvalidInputFile>([&]() {
+            fc::Header::Parse(corrupted);
+        }, "no iterations");
+
+        // Unknown flags.
+        corrupted = bytes;
+        corrupted[10] |= 0x80;
+        fc::test::CheckThrows<fc::error::InvalidInputFile>([&]() {
+            fc::Header::Parse(corrupted);
+        }, "unknown flags");
+    }
+}
+
+int main() {
+    // One master key and two passwords for all formats.
+    const auto key = fc::Key::Generate();
+    const fc::Password password("first password");
+    const fc::Password otherPassword("second password");
+    CheckLegacy(key, password, otherPassword);
+    CheckFishCodeSlots(key, password, otherPassword);
+    CheckDerivedSlots(key, password, otherPassword);
+    CheckInvalid(key, password);
+    return fc::test::GetResult();
+}
@@ -0,0 +1,159 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "check.hpp"
+#include "cipher.hpp"
+#include "error.hpp"
+#include "header.hpp"
+#include "inplace.hpp"
+#include "key.hpp"
+#include "password.hpp"
+
+namespace {
+    // Ten whole chunks and a partial one.
+    constexpr const std::size_t CHUNK_SIZE = 4096;
+    constexpr const std::size_t DATA_SIZE = 10 * CHUNK_SIZE + 100;
+    constexpr const std::size_t CHUNKS = (DATA_SIZE + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    void WriteBytes(
+        const std::filesystem::path& fsPath,
+        std::span<const std::uint8_t> bytes,
+        const std::size_t offset
+    ) {
+        std::fstream stream(fsPath, std::ios::in | std::ios::out | std::ios::binary);
+        stream.seekp(static_cast<std::streamoff>(offset));
+        stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    // Stops the task before the chunk 'stopIndex' (the chunks before it are done, the journal holds the last one).
+    fc::ProgressFunction StopBefore(const std::size_t stopIndex) {
+        return [stopIndex, index = std::size_t(0)](const std::uint64_t, const std::uint64_t) mutable {
+            return index++ != stopIndex;
+        };
+    }
+
+    bool Continue(const std::uint64_t, const std::uint64_t) {
+        return true;
+    }
+
+    // Simulates a crash while the chunk was written: its place holds neither the old nor the new bytes.
+    void TearChunk(const std::filesystem::path& fsPath, const std::size_t offset) {
+        const std::vector<std::uint8_t> garbage(CHUNK_SIZE, 0xEE);
+        WriteBytes(fsPath, garbage, offset);
+    }
+
+    void CheckEncrypt(const std::filesystem::path& fsPath, const std::vector<std::uint8_t>& plain) {
+        const fc::Password password("journal password");
+        const fc::Password wrongPassword("wrong password");
+
+        // Interrupt the encryption after three chunks (they are moved backwards, from the end of the file).
+        const auto isStopped = !fc::EncryptInPlace(fsPath, password, fc::CipherSuite::CS_AES128_CTR, CHUNK_SIZE,
+            StopBefore(3));
+        fc::test::Check(isStopped && fc::HasJournal(fsPath), "encryption stopped");
+
+        // Crash in the middle of the last chunk (the third one from the end, behind the header).
+        const auto headerSize = fc::Header(fc::CipherSuite::CS_AES128_CTR, fc::Key(), password,
+            fc::Header::DEFAULT_SLOTS).GetSize();
+        TearChunk(fsPath, headerSize + (CHUNKS - 3) * CHUNK_SIZE);
+
+        // Only the same task with the same password resumes it.
+        fc::test::CheckThrows<fc::error::UnfinishedTask>([&]() {
+            fc::DecryptInPlace(fsPath, password, CHUNK_SIZE, Continue);
+        }, "other task");
+        fc::test::CheckThrows<fc::error::InvalidPassword>([&]() {
+            fc::EncryptInPlace(fsPath, wrongPassword, fc::CipherSuite::CS_AES128_CTR, CHUNK_SIZE, Continue);
+        }, "wrong password");
+
+        // Resume the task, the chunk in flight is replayed from the journal.
+        const auto isCompleted = fc::EncryptInPlace(fsPath, password, fc::CipherSuite::CS_AES128_CTR, CHUNK_SIZE,
+            Continue);
+        fc::test::Check(isCompleted && !fc::HasJournal(fsPath), "encryption resumed");
+
+        // Decrypt the file without the journal code.
+        auto bytes = fc::test::ReadBytes(fsPath);
+        const auto header = fc::Header::Parse(bytes);
+        fc::test::Check(bytes.size() == header.GetSize() + plain.size(), "encrypted size");
+        const auto data = std::span<std::uint8_t>(bytes).subspan(header.GetSize());
+        fc::Cipher(header.GetSuite(), header.UnwrapKey(password)).Decrypt(data, 0);
+        fc::test::Check(std::equal(data.begin(), data.end(), plain.begin(), plain.end()), "encrypted data");
+    }
+
+    void CheckDecrypt(const std::filesystem::path& fsPath, const std::vector<std::uint8_t>& plain) {
+        const fc::Password password("journal password");
+
+        // Interrupt the decryption after four chunks (they are moved forwards, over the header).
+        const auto isStopped = !fc::DecryptInPlace(fsPath, password, CHUNK_SIZE, StopBefore(4));
+        fc::test::Check(isStopped && fc::HasJournal(fsPath), "decryption stopped");
+
+        // Crash in the middle of the last chunk and resume the task.
+        TearChunk(fsPath, 3 * CHUNK_SIZE);
+        const auto isCompleted = fc::DecryptInPlace(fsPath, password, CHUNK_SIZE, Continue);
+        fc::test::Check(isCompleted && !fc::HasJournal(fsPath), "decryption resumed");
+        fc::test::Check(fc::test::ReadBytes(fsPath) == plain, "decrypted data");
+    }
+
+    // A file which can't change its size (a pipe here, a device alike) is refused before the journal is created.
+    void CheckNonRegular(const std::filesystem::path& fsPath) {
+        const fc::Password password("journal password");
+        if (mkfifo(fsPath.c_str(), 0600) != 0) {
+            fc::test::Check(false, "pipe created");
+            return;
+        }
+        fc::test::CheckThrows<fc::error::InvalidFileIO>([&]() {
+            fc::EncryptInPlace(fsPath, password, fc::CipherSuite::CS_AES128_CTR, CHUNK_SIZE, Continue);
+        }, "pipe encrypted");
+        fc::test::CheckThrows<fc::error::InvalidFileIO>([&]() {
+            fc::DecryptInPlace(fsPath, password, CHUNK_SIZE, Continue);
+        }, "pipe decrypted");
+        fc::test::Check(!fc::HasJournal(fsPath), "pipe journal");
+        std::filesystem::remove(fsPath);
+    }
+}
+
+int main() {
+    // Plain file in the temporary directory.
+    const auto fsPath = std::filesystem::temp_directory_path() / ("fishcode_journal_" + std::to_string(getpid()));
+    std::vector<std::uint8_t> plain(DATA_SIZE);
+    for (std::size_t index = 0; index < plain.size(); index++) {
+        plain[index] = static_cast<std::uint8_t>(index * 131 + 7);
+    }
+    std::ofstream(fsPath, std::ios::binary).write(reinterpret_cast<const char*>(plain.data()), plain.size());
+
+    // Encrypt and decrypt it in place, both interrupted by a crash.
+    CheckEncrypt(fsPath, plain);
+    CheckDecrypt(fsPath, plain);
+
+    // Replace the file by a pipe.
+    std::filesystem::remove(fsPath);
+    CheckNonRegular(fsPath);
+
+    // Remove the journal of a failed test.
+    std::filesystem::remove(fc::GetJournalPath(fsPath));
+    return fc::test::GetResult();
+}
@@ -0,0 +1,107 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "block.hpp"
+#include "check.hpp"
+#include "compiled.hpp"
+#include "kernel.hpp"
+#include "key.hpp"
+
+namespace {
+    // Lengths with full blocks only and with a partial last block, below and above the step of the widest kernel (8
+    // blocks, 128 bytes).
+    constexpr const std::size_t LENGTHS[] = {
+        0, 1, 15, 16, 17, 31, 64, 100, 112, 127, 128, 129, 143, 144, 145, 255, 1024, 1040, 1041, 4099
+    };
+
+    std::vector<std::uint8_t> MakeBytes(const std::size_t length) {
+        // Every byte depends on its position.
+        std::vector<std::uint8_t> bytes(length);
+        for (std::size_t index = 0; index < length; index++) {
+            bytes[index] = static_cast<std::uint8_t>(index * 131 + 7);
+        }
+        return bytes;
+    }
+
+    std::vector<std::uint8_t> EncryptReference(std::vector<std::uint8_t> bytes, const fc::Key& key) {
+        // Encrypt block by block with the reference rounds (the last block may be partial).
+        for (std::size_t offset = 0; offset < bytes.size(); offset += fc::Block::SIZE) {
+            const auto realSize = std::min(bytes.size() - offset, fc::Block::SIZE);
+            fc::Block block;
+            std::copy_n(bytes.begin() + offset, realSize, block.GetData());
+            block.Encrypt(key, realSize);
+            std::copy_n(block.GetData(), realSize, bytes.begin() + offset);
+        }
+        return bytes;
+    }
+
+    void CheckBlock(const fc::Key& key, const fc::CompiledKey& compiledKey) {
+        // The compiled key of every block length matches the reference rounds.
+        for (std::size_t realSize = 1; realSize <= fc::Block::SIZE; realSize++) {
+            const auto plain = MakeBytes(realSize);
+            const auto reference = EncryptReference(plain, key);
+            auto bytes = plain;
+            compiledKey.Encrypt(bytes.data(), realSize);
+            fc::test::Check(bytes == reference, "compiled key, length " + std::to_string(realSize));
+            compiledKey.Decrypt(bytes.data(), realSize);
+            fc::test::Check(bytes == plain, "compiled key round trip, length " + std::to_string(realSize));
+        }
+    }
+
+    void CheckKernel(const fc::kernel::Kernel& kernel, const fc::Key& key, const fc::CompiledKey& compiledKey) {
+        // The span API runs the active kernel.
+        fc::kernel::SetActive(kernel.name);
+        for (const auto length : LENGTHS) {
+            const auto what = std::string(kernel.name) + ", length " + std::to_string(length);
+            const auto plain = MakeBytes(length);
+            auto bytes = plain;
+            compiledKey.Encrypt(std::span<std::uint8_t>(bytes));
+            fc::test::Check(bytes == EncryptReference(plain, key), what);
+            compiledKey.Decrypt(std::span<std::uint8_t>(bytes));
+            fc::test::Check(bytes == plain, what + " (round trip)");
+        }
+    }
+}
+
+int main() {
+    // Fixed key (the results are reproducible) and a random one.
+    std::array<std::uint8_t, fc::Key::SIZE> keyBytes;
+    for (std::size_t index = 0; index < keyBytes.size(); index++) {
+        keyBytes[index] = static_cast<std::uint8_t>(index * 17 + 3);
+    }
+    for (const auto& key : {fc::Key(keyBytes), fc::Key::Generate()}) {
+        const fc::CompiledKey compiledKey(key);
+        CheckBlock(key, compiledKey);
+
+        // Every kernel this CPU can run is bit-exact with the reference rounds.
+        for (const auto& kernel : fc::kernel::GetKernels()) {
+            if (kernel.IsSupported()) {
+                CheckKernel(kernel, key, compiledKey);
+            }
+        }
+    }
+    return fc::test::GetResult();
+}
@@ -0,0 +1,126 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <unistd.h>
+#include "check.hpp"
+#include "cipher.hpp"
+#include "file.hpp"
+#include "key.hpp"
+#include "transform.hpp"
+
+namespace {
+    // Several chunks, the task is cancelled in the middle.
+    constexpr const std::size_t CHUNK_SIZE = 64 << 10;
+    constexpr const std::size_t DATA_SIZE = 10 * CHUNK_SIZE + 100;
+    constexpr const std::size_t STOP_INDEX = 4;
+
+    // Checks if a temporary file of 'ofPath' is left in its directory (see CreateTemporary).
+    bool HasTemporaryFile(const std::filesystem::path& ofPath) {
+        const auto prefix = ofPath.filename().string() + ".tmp";
+        for (const auto& entry : std::filesystem::directory_iterator(ofPath.parent_path())) {
+            if (entry.path().filename().string().starts_with(prefix)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Runs the task as TaskEncrypt and FinishTask do: a cancelled task removes the output file, a completed one links
+    // it under its name.
+    void CheckBackend(
+        const std::filesystem::path& ifPath,
+        const std::filesystem::path& ofPath,
+        const fc::FileBackend backend,
+        const std::vector<std::uint8_t>& encrypted,
+        const fc::Cipher& cipher
+    ) {
+        const auto what = "backend " + std::to_string(static_cast<int>(backend));
+        const auto encrypt = [&](auto chunk, auto offset) {
+            cipher.Encrypt(chunk, offset);
+        };
+
+        // Cancel the task, the output file never appears under its name.
+        {
+            fc::File inputFile(ifPath, fc::FileType::FT_INPUT, backend, std::filesystem::path());
+            fc::File outputFile(ofPath, fc::FileType::FT_OUTPUT, backend, std::filesystem::path());
+            std::size_t index = 0;
+            const auto isCompleted = fc::TransformFile(inputFile, outputFile, DATA_SIZE, CHUNK_SIZE, encrypt,
+                [&](auto, auto) {
+                    fc::test::Check(!std::filesystem::exists(ofPath), what + ", no output during the task");
+                    return index++ != STOP_INDEX;
+                }
+            );
+            fc::test::Check(!isCompleted, what + ", task cancelled");
+            outputFile.Remove();
+        }
+        fc::test::Check(!std::filesystem::exists(ofPath), what + ", no output after cancellation");
+        fc::test::Check(!HasTemporaryFile(ofPath), what + ", no temporary file after cancellation");
+
+        // Complete the task, the whole output file appears at once.
+        {
+            fc::File inputFile(ifPath, fc::FileType::FT_INPUT, backend, std::filesystem::path());
+            fc::File outputFile(ofPath, fc::FileType::FT_OUTPUT, backend, std::filesystem::path());
+            const auto isCompleted = fc::TransformFile(inputFile, outputFile, DATA_SIZE, CHUNK_SIZE, encrypt,
+                [](auto, auto) {
+                    return true;
+                }
+            );
+            fc::test::Check(isCompleted, what + ", task completed");
+            outputFile.Flush();
+            outputFile.Link();
+        }
+        fc::test::Check(fc::test::ReadBytes(ofPath) == encrypted, what + ", output file");
+        fc::test::Check(!HasTemporaryFile(ofPath), what + ", no temporary file after completion");
+        std::filesystem::remove(ofPath);
+    }
+}
+
+int main() {
+    // Plain file in the temporary directory.
+    const auto directory = std::filesystem::temp_directory_path();
+    const auto ifPath = directory / ("fishcode_output_" + std::to_string(getpid()));
+    const auto ofPath = directory / ("fishcode_output_" + std::to_string(getpid()) + ".out");
+    std::vector<std::uint8_t> plain(DATA_SIZE);
+    for (std::size_t index = 0; index < plain.size(); index++) {
+        plain[index] = static_cast<std::uint8_t>(index * 131 + 7);
+    }
+    std::ofstream(ifPath, std::ios::binary).write(reinterpret_cast<const char*>(plain.data()), plain.size());
+
+    // Expected output of a completed task.
+    const fc::Cipher cipher(fc::CipherSuite::CS_AES128_CTR, fc::Key::Generate());
+    auto encrypted = plain;
+    cipher.Encrypt(encrypted, 0);
+
+    // Every backend writes the output file without a name until the task is completed.
+    for (const auto backend : {
+        fc::FileBackend::FB_STREAM, fc::FileBackend::FB_MMAP, fc::FileBackend::FB_URING,
+        fc::FileBackend::FB_DIRECT, fc::FileBackend::FB_FADVISE
+    }) {
+        CheckBackend(ifPath, ofPath, backend, encrypted, cipher);
+    }
+    std::filesystem::remove(ifPath);
+    return fc::test::GetResult();
+}
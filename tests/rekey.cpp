@@ -0,0 +1,68 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <span>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "check.hpp"
+#include "cipher.hpp"
+#include "key.hpp"
+
+namespace {
+    // Whole chunks and a partial last block.
+    constexpr const std::size_t DATA_SIZE = 1000;
+    constexpr const std::size_t CHUNK_SIZE = 256;
+
+    void CheckRekey(const fc::CipherSuite suite) {
+        // Encrypt the same data with both keys.
+        const auto what = std::string("suite ") + std::to_string(static_cast<int>(suite));
+        const auto oldKey = fc::Key::Generate();
+        const auto newKey = fc::Key::Generate();
+        std::vector<std::uint8_t> plain(DATA_SIZE);
+        for (std::size_t index = 0; index < plain.size(); index++) {
+            plain[index] = static_cast<std::uint8_t>(index * 131 + 7);
+        }
+        auto bytes = plain;
+        fc::Cipher(suite, oldKey).Encrypt(bytes, 0);
+        auto expected = plain;
+        fc::Cipher(suite, newKey).Encrypt(expected, 0);
+
+        // Map the old ciphertext to the new one by chunks (as the rekey task does).
+        const fc::KeyDelta delta(suite, oldKey, newKey);
+        for (std::size_t offset = 0; offset < bytes.size(); offset += CHUNK_SIZE) {
+            const auto size = std::min(bytes.size() - offset, CHUNK_SIZE);
+            delta.Apply(std::span<std::uint8_t>(bytes).subspan(offset, size), offset);
+        }
+        fc::test::Check(bytes == expected, what + " rekey");
+
+        // The new key decrypts the result.
+        fc::Cipher(suite, newKey).Decrypt(bytes, 0);
+        fc::test::Check(bytes == plain, what + " decrypt after rekey");
+    }
+}
+
+int main() {
+    // Both cipher suites.
+    CheckRekey(fc::CipherSuite::CS_FISHCODE);
+    CheckRekey(fc::CipherSuite::CS_AES128_CTR);
+    return fc::test::GetResult();
+}
@@ -0,0 +1,145 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <unistd.h>
+#include "check.hpp"
+#include "cipher.hpp"
+#include "error.hpp"
+#include "file.hpp"
+#include "header.hpp"
+#include "key.hpp"
+#include "password.hpp"
+#include "sparse.hpp"
+
+namespace {
+    // Data, a hole, data and a hole up to the end of the file.
+    constexpr const std::uint64_t DATA_SIZE = 4096;
+    constexpr const std::uint64_t SECOND_DATA = 1 << 20;
+    constexpr const std::uint64_t FILE_SIZE = 3 << 20;
+
+    void CheckSetting() {
+        // Holes are skipped only on request (their layout is stored unencrypted).
+        unsetenv("FISHCODE_SPARSE");
+        fc::test::Check(!fc::File::GetSparseSetting(), "sparse setting is off by default");
+        setenv("FISHCODE_SPARSE", "0", 1);
+        fc::test::Check(!fc::File::GetSparseSetting(), "sparse setting 0");
+        setenv("FISHCODE_SPARSE", "1", 1);
+        fc::test::Check(fc::File::GetSparseSetting(), "sparse setting 1");
+        unsetenv("FISHCODE_SPARSE");
+    }
+
+    void CheckHeader() {
+        // Extents must be ascending and fit the file.
+        fc::test::CheckThrows<fc::error::InvalidInputFile>([]() {
+            fc::ExtentMap({{SECOND_DATA, DATA_SIZE}, {0, DATA_SIZE}}, FILE_SIZE);
+        }, "descending extents");
+        fc::test::CheckThrows<fc::error::InvalidInputFile>([]() {
+            fc::ExtentMap({{FILE_SIZE - 1, DATA_SIZE}}, FILE_SIZE);
+        }, "extent past the end");
+
+        // The extents survive the header round trip.
+        const fc::ExtentMap extents({{0, DATA_SIZE}, {SECOND_DATA, DATA_SIZE}}, FILE_SIZE);
+        fc::Header header(fc::CipherSuite::CS_FISHCODE, fc::Key::Generate(), fc::Password("sparse"), 1, 1000);
+        const auto plainSize = header.GetSize();
+        header.SetExtents(extents);
+        const auto bytes = header.Serialize();
+        fc::test::Check(bytes.size() == header.GetSize() && header.GetSize() > plainSize, "header size");
+        const auto parsed = fc::Header::Parse(bytes).GetExtents();
+        fc::test::Check(parsed.GetSize() == FILE_SIZE && parsed.GetDataSize() == 2 * DATA_SIZE, "parsed extents");
+        fc::test::Check(parsed.GetExtents().size() == 2 && parsed.GetExtents()[1].offset == SECOND_DATA, "extents");
+    }
+
+    void CheckFile(
+        const std::filesystem::path& ifPath,
+        const std::filesystem::path& ofPath,
+        const fc::FileBackend backend
+    ) {
+        const auto what = "backend " + std::to_string(static_cast<int>(backend));
+
+        // Read the data of the extents only.
+        fc::File inputFile(ifPath, fc::FileType::FT_INPUT, backend, std::filesystem::path());
+        const auto extents = inputFile.FindExtents();
+        inputFile.SetExtents(extents);
+        std::vector<std::uint8_t> data(static_cast<std::size_t>(extents.GetDataSize()) + 1);
+        const auto dataSize = inputFile.ReadChunk(data);
+        fc::test::Check(dataSize == extents.GetDataSize(), what + ", data size");
+        data.resize(dataSize);
+
+        // Write it back to the extents of the output file (the holes are recreated).
+        {
+            fc::File outputFile(ofPath, fc::FileType::FT_OUTPUT, backend, std::filesystem::path());
+            outputFile.SetExtents(extents);
+            outputFile.Reserve(dataSize);
+            outputFile.WriteChunk(data);
+            outputFile.Flush();
+            outputFile.Link();
+        }
+        fc::test::Check(fc::test::ReadBytes(ofPath) == fc::test::ReadBytes(ifPath), what + ", output file");
+        fc::test::Check(fc::ExtentMap::Find(ofPath).GetDataSize() < FILE_SIZE, what + ", output holes");
+        std::filesystem::remove(ofPath);
+    }
+}
+
+int main() {
+    // Format of the extents.
+    CheckSetting();
+    CheckHeader();
+
+    // Sparse file in the temporary directory.
+    const auto directory = std::filesystem::temp_directory_path();
+    const auto ifPath = directory / ("fishcode_sparse_" + std::to_string(getpid()));
+    const auto ofPath = directory / ("fishcode_sparse_" + std::to_string(getpid()) + ".out");
+    {
+        std::ofstream stream(ifPath, std::ios::binary);
+        const std::vector<char> data(DATA_SIZE, 'D');
+        stream.write(data.data(), DATA_SIZE);
+        stream.seekp(SECOND_DATA);
+        stream.write(data.data(), DATA_SIZE);
+    }
+    std::filesystem::resize_file(ifPath, FILE_SIZE);
+
+    // The file system may not report holes (then there is nothing to skip).
+    const auto extents = fc::ExtentMap::Find(ifPath);
+    if (!extents.IsSparse()) {
+        std::cerr << "The file system does not report holes, the sparse file is not checked." << std::endl;
+    } else {
+        // Both pieces of data are found, the holes are skipped.
+        fc::test::Check(extents.GetSize() == FILE_SIZE, "file size");
+        fc::test::Check(extents.GetDataSize() >= 2 * DATA_SIZE, "data found");
+        fc::test::Check(extents.GetDataSize() <= FILE_SIZE - fc::ExtentMap::MIN_HOLE_SIZE, "holes found");
+
+        // Every backend reads and writes the extents only.
+        for (const auto backend : {
+            fc::FileBackend::FB_STREAM, fc::FileBackend::FB_MMAP, fc::FileBackend::FB_URING,
+            fc::FileBackend::FB_DIRECT, fc::FileBackend::FB_FADVISE
+        }) {
+            CheckFile(ifPath, ofPath, backend);
+        }
+    }
+    std::filesystem::remove(ifPath);
+    return fc::test::GetResult();
+}
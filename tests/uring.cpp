@@ -0,0 +1,118 @@
+/*
+** Copyright (C) 2025 Vitaliy Tarasenko.
+**
+** This file is part of FishCode (fishcode).
+**
+** FishCode is free software: you can redistribute it and/or modify it under
+** the terms of the GNU General Public License as published by the Free
+** Software Foundation, either version 3 of the License, or (at your option)
+** any later version.
+**
+** FishCode is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+** FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+** more details.
+**
+** You should have received a copy of the GNU General Public License along
+** with FishCode. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <unistd.h>
+#include "check.hpp"
+#include "cipher.hpp"
+#include "file.hpp"
+#include "key.hpp"
+#include "transform.hpp"
+#include "uring.hpp"
+
+namespace {
+    // More chunks than the ring keeps in flight and a partial one, behind a prefix in place of the header.
+    constexpr const std::size_t CHUNK_SIZE = 64 << 10;
+    constexpr const std::size_t DATA_SIZE = 20 * CHUNK_SIZE + 100;
+    constexpr const std::size_t PREFIX_SIZE = 16;
+
+    bool Continue(const std::uint64_t, const std::uint64_t) {
+        return true;
+    }
+
+    // Copies the prefix and transforms the rest of the file through the backend from FISHCODE_IO (as the tasks do).
+    void TransformWith(
+        const char* backend,
+        const std::filesystem::path& ifPath,
+        const std::filesystem::path& ofPath,
+        const fc::TransformFunction& transform
+    ) {
+        setenv("FISHCODE_IO", backend, 1);
+        fc::File inputFile(ifPath, fc::FileType::FT_INPUT);
+        fc::File outputFile(ofPath, fc::FileType::FT_OUTPUT);
+        unsetenv("FISHCODE_IO");
+        if (fc::Ring::IsSupported()) {
+            fc::test::Check(inputFile.IsAsync() == (std::string(backend) == "uring"), std::string(backend) + " files");
+        }
+
+        // Copy the prefix.
+        std::vector<std::uint8_t> prefix(PREFIX_SIZE);
+        fc::test::Check(inputFile.ReadChunk(prefix) == PREFIX_SIZE, "prefix read");
+        outputFile.WriteChunk(prefix);
+
+        // Transform the data and give the output file its name.
+        const auto total = static_cast<std::uint64_t>(inputFile.GetSize()) - PREFIX_SIZE;
+        const auto isCompleted = fc::TransformFile(inputFile, outputFile, total, CHUNK_SIZE, transform, Continue);
+        fc::test::Check(isCompleted, std::string(backend) + " task completed");
+        outputFile.Flush();
+        outputFile.Link();
+    }
+}
+
+int main() {
+    // The ring is used only if the kernel has io_uring (the stream is used instead otherwise).
+    if (!fc::Ring::IsSupported()) {
+        std::cerr << "The kernel has no io_uring, the stream is checked against itself." << std::endl;
+    }
+
+    // Plain file in the temporary directory.
+    const auto basePath = std::filesystem::temp_directory_path() / ("fishcode_uring_" + std::to_string(getpid()));
+    const auto plainPath = basePath;
+    auto streamPath = basePath, uringPath = basePath, decryptedPath = basePath;
+    streamPath += ".stream";
+    uringPath += ".uring";
+    decryptedPath += ".decrypted";
+    std::vector<std::uint8_t> plain(PREFIX_SIZE + DATA_SIZE);
+    for (std::size_t index = 0; index < plain.size(); index++) {
+        plain[index] = static_cast<std::uint8_t>(index * 131 + 7);
+    }
+    std::ofstream(plainPath, std::ios::binary).write(reinterpret_cast<const char*>(plain.data()), plain.size());
+
+    // Encrypt the file through both backends with the same key.
+    const fc::Cipher cipher(fc::CipherSuite::CS_AES128_CTR, fc::Key::Generate());
+    const auto encrypt = [&](auto chunk, auto offset) {
+        cipher.Encrypt(chunk, offset);
+    };
+    TransformWith("stream", plainPath, streamPath, encrypt);
+    TransformWith("uring", plainPath, uringPath, encrypt);
+    const auto encrypted = fc::test::ReadBytes(uringPath);
+    fc::test::Check(encrypted == fc::test::ReadBytes(streamPath), "encrypted data");
+    fc::test::Check(encrypted != plain, "data encrypted");
+
+    // Decrypt it back through io_uring.
+    TransformWith("uring", uringPath, decryptedPath, [&](auto chunk, auto offset) {
+        cipher.Decrypt(chunk, offset);
+    });
+    fc::test::Check(fc::test::ReadBytes(decryptedPath) == plain, "decrypted data");
+
+    // Remove the files.
+    for (const auto& fsPath : {plainPath, streamPath, uringPath, decryptedPath}) {
+        std::filesystem::remove(fsPath);
+    }
+    return fc::test::GetResult();
+}